@@ -1,48 +1,207 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <queue>
 #include <shared_mutex>
 #include <stack>
 #include <thread>
+#include <type_traits>
 #include <unordered_map>
 
 #include "base_node.h"
+#include "block_codec.h"
+#include "buffered_writer.h"
+#include "epoch_manager.h"
 #include "internal_node.h"
 #include "leaf_node.h"
+#include "operation_gate.h"
+#include "range_cursor.h"
+#include "write_ahead_log.h"
 
-template <typename Key>
+// 范围查询选项：最多返回limit个条目，边界可分别设为开区间
+struct RangeOptions {
+    size_t limit = SIZE_MAX;
+    bool start_inclusive = true;
+    bool end_inclusive = true;
+};
+
+// 范围聚合结果（对值），count为0时min/max无意义
+struct RangeAggregate {
+    size_t count = 0;
+    uint64_t sum = 0;
+    uint64_t min = UINT64_MAX;
+    uint64_t max = 0;
+};
+
+// Order为0时阶数在运行时由构造参数决定；
+// Order大于0时阶数为编译期常量，内联的容量判断随之常量折叠；节点内查找与运行时阶数相同。
+// Order只能取b_plus_tree.cpp末尾显式实例化的值（int键16/64/128/256，std::string键16/64），其他值在编译期报错
+template <typename Key, int Order = 0>
 class BPlusTree {
+    static_assert(Order == 0 ||
+                      (std::is_same<Key, int>::value && (Order == 16 || Order == 64 || Order == 128 || Order == 256)) ||
+                      (std::is_same<Key, std::string>::value && (Order == 16 || Order == 64)),
+                  "Unsupported Order: use 0 or a value instantiated in b_plus_tree.cpp");
+
    private:
     int order;
-    BaseNode<Key>* root;
-    LeafNode<Key>* head_leaf;
-    mutable std::shared_mutex root_mutex;
-    mutable std::shared_mutex tree_mutex;
+    // 根节点只在持有旧根写锁时被替换，因此无需单独的根节点锁
+    std::atomic<BaseNode<Key>*> root;
+    // 最左叶子，空树时由ensure_root先于根节点发布，读者无需持锁即可读取
+    std::atomic<LeafNode<Key>*> head_leaf;
+    // 热路径操作只登记本线程槽位，序列化/反序列化时独占
+    mutable OperationGate tree_gate;
+
+    // 已摘除但乐观读者可能仍在访问的节点，待所有读者离开后再释放
+    mutable EpochManager epoch_manager;
+
+    // 计数模式：维护每个节点的子树键数，range_count/size/rank/select为O(log n)。
+    // 插入和删除在叶子写锁内把键数变化沿父指针原子地累加到各祖先，期间持有count_mutex共享锁；
+    // 分裂、合并和借用改写父指针并在节点间转移键数，只在修改节点的片刻持有count_mutex独占锁，
+    // 此时没有进行中的累加。读取方按共享锁逐层交接下降，不持有count_mutex
+    bool counted;
+    mutable std::shared_mutex count_mutex;
+    // 结构调整期间为奇数；读取方下降前后比较，变化时重试，不会看到键数只转移了一半的节点
+    std::atomic<uint64_t> count_version;
+
+    // 键可按位拷贝时，读路径使用乐观锁（版本号校验）而非共享锁
+    static constexpr bool optimistic_read = std::is_trivially_copyable<Key>::value;
+
+    // 持久化模式下的预写日志，为空时写操作不记日志
+    // 日志分段存放在wal_base.wal.<段号>，检查点之前的段在检查点完成后删除
+    std::unique_ptr<WriteAheadLog> wal;
+    std::string wal_base;  // 检查点与日志的文件名前缀
+    uint64_t wal_first_segment = 0;
+    uint64_t wal_segment = 0;  // 当前追加的段
+    std::mutex checkpoint_mutex;
+    std::vector<uint64_t> checkpoint_deltas;  // 当前全量检查点之上的增量检查点
+    size_t max_checkpoint_deltas = 0;
+    std::atomic<bool> checkpoint_full{true};  // 下一次检查点必须为全量
+
+    // 游标每批至少复制的条目数（按整叶复制）
+    static constexpr size_t scan_batch_size = 64;
+    friend class RangeCursor<Key, Order>;
+
+    int node_order() const { return Order > 0 ? Order : order; }
+    void ensure_root();
+    void clear_tree();
+    void add_count(BaseNode<Key>* node, int64_t delta);
+    void begin_count_change(std::unique_lock<std::shared_mutex>& count_lock);
+    void end_count_change(std::unique_lock<std::shared_mutex>& count_lock);
+    uint64_t read_count_version() const;
+    bool validate_count_version(uint64_t version) const;
+    static int64_t adopt_split_chain(BaseNode<Key>* child, BaseNode<Key>* from, BaseNode<Key>* stop = nullptr);
+    int64_t recount(BaseNode<Key>* node);
+    int64_t count_before(const Key& key, bool inclusive) const;
+    LeafNode<Key>* select_leaf(size_t& k) const;
 
     LeafNode<Key>* find_leaf(const Key& key, std::queue<BaseNode<Key>*>& unique_locked_parent,
                              bool for_write = false) const;
+    LeafNode<Key>* lock_leaf_shared(const Key& key) const;
+    std::vector<std::pair<Key, uint64_t>> range_collect(const Key& start, const Key* end,
+                                                        const RangeOptions& options) const;
+    void scan_batch(const Key& from, bool inclusive, std::vector<std::pair<Key, uint64_t>>& batch) const;
+    LeafNode<Key>* lock_leaf_before(const Key& key, Key& low_key, bool& has_low_key) const;
+    void scan_batch_reverse(const Key& from, bool inclusive, std::vector<std::pair<Key, uint64_t>>& batch) const;
+    BaseNode<Key>* lock_root_shared() const;
+    BaseNode<Key>* find_node_shared(const Key& key, int level) const;
+    BaseNode<Key>* find_node_optimistic(const Key& key, int level, uint64_t& node_version) const;
+    BaseNode<Key>* lock_node(const Key& key, int level);
+    static BaseNode<Key>* right_link(BaseNode<Key>* node);
+    void link_levels();
     void handle_split(BaseNode<Key>* node);
     void handle_underflow(BaseNode<Key>* node);
     void merge_nodes(InternalNode<Key>* parent, int left_index, bool is_leaf);
+    void retire_node(BaseNode<Key>* node);
+    static void delete_node(void* node);
 
-    void serialize_key(std::ofstream& file, const int& key);
-    void serialize_key(std::ofstream& file, const std::string& key);
+    uint64_t log_write(char op, const Key& key, uint64_t value);
+    void log_commit(uint64_t lsn);
+    void apply_log_record(const char* data, size_t size);
+    void write_checkpoint(const std::string& path, uint64_t segment, bool only_dirty);
+    uint64_t read_checkpoint(const std::string& path, std::vector<std::pair<Key, uint64_t>>& items);
+    std::string checkpoint_path(uint64_t delta_segment) const;
+    std::string wal_segment_path(uint64_t segment) const;
+
+    void serialize_key(BufferedFileWriter& file, const int& key);
+    void serialize_key(BufferedFileWriter& file, const std::string& key);
     Key deserialize_key(std::ifstream& file);
+    BaseNode<Key>* read_node(std::ifstream& file, int32_t& node_id, int32_t& next_leaf_id,
+                             std::vector<int32_t>& children_ids);
+    bool deserialize_indexed(const std::string& base_filename, int32_t root_id, int32_t head_leaf_id,
+                             int num_threads);
 
    public:
-    BPlusTree(int order);
+    // 所有操作都是线程安全的，按线程槽位登记（见thread_registry.h）。同时存活且访问过树的线程
+    // 超过MAX_THREAD_SLOTS（256）时，多出的线程共用一个溢出槽位，它们的操作彼此串行执行
+    // counted为true时启用计数模式：range_count/size/rank/select为O(log n)，
+    // 代价是每次写入要原子地更新到根的一条路径上的计数，分裂、合并和借用之间互斥。
+    // 并发写入期间读到的计数可能尚未包含进行中的写操作，没有写操作时精确
+    BPlusTree(int order = Order, bool counted = false);
     ~BPlusTree();
 
     void insert(const Key& key, uint64_t value);
+    // 批量插入，同一叶子的键在一次加锁内写入；批内重复键以最后一个为准
+    void insert_batch(std::vector<std::pair<Key, uint64_t>> batch);
     void remove(const Key& key);
     uint64_t find(const Key& key) const;
+    // 批量查找，结果与keys一一对应，不存在的键为0
+    std::vector<uint64_t> find_batch(const std::vector<Key>& keys) const;
     std::vector<std::pair<Key, uint64_t>> range_find(const Key& start, const Key& end) const;
+    // 分页查询：从start开始最多返回options.limit个条目，无上界
+    std::vector<std::pair<Key, uint64_t>> range_find(const Key& start, const RangeOptions& options) const;
+    std::vector<std::pair<Key, uint64_t>> range_find(const Key& start, const Key& end,
+                                                     const RangeOptions& options) const;
+    // 从第一个不小于start的键开始的游标，按需逐批读取，可随时停止
+    RangeCursor<Key, Order> scan(const Key& start) const;
+    // 范围聚合，直接在叶子上归约，不复制条目；计数模式下range_count只需两次下降，普通模式下随范围内的条目数线性增长
+    size_t range_count(const Key& start, const Key& end) const;
+    uint64_t range_sum(const Key& start, const Key& end) const;
+    RangeAggregate range_aggregate(const Key& start, const Key& end) const;
+    // 按键递增访问[start, end]内的条目，visitor返回false时停止
+    void range_visit(const Key& start, const Key& end,
+                     const std::function<bool(const Key&, uint64_t)>& visitor) const;
+
+    // 顺序统计：rank为小于key的键数，select返回第k小（从0开始）的条目，k越界时抛出异常。
+    // 计数模式下为O(log n)；普通模式（counted为false）下沿叶子链逐叶计数，为O(n)
+    size_t size() const;
+    size_t rank(const Key& key) const;
+    std::pair<Key, uint64_t> select(size_t k) const;
+
+    // 逆序游标：从最后一个不大于start的键开始按键递减返回
+    RangeCursor<Key, Order> scan_reverse(const Key& start) const;
+    // [start, end]内的条目按键递减返回，最多limit个
+    std::vector<std::pair<Key, uint64_t>> range_find_reverse(const Key& start, const Key& end,
+                                                             size_t limit = SIZE_MAX) const;
+
+    // 从按键严格递增的输入自底向上构建，替换树的当前内容。
+    // fill_factor为叶子和内部节点的填充率，num_threads大于1时并行构建叶子层
+    void bulk_load(typename std::vector<std::pair<Key, uint64_t>>::const_iterator first,
+                   typename std::vector<std::pair<Key, uint64_t>>::const_iterator last, double fill_factor = 1.0,
+                   int num_threads = 1);
 
     void serialize(const std::string& base_filename);
-    void deserialize(const std::string& base_filename);
+    // 快照带有节点偏移索引（.index）时按记录分块，num_threads个线程并行构建节点并建立链接
+    void deserialize(const std::string& base_filename, int num_threads = 1);
+    // 写出可直接映射查询的快照，由MappedSnapshot打开
+    void serialize_mapped(const std::string& path);
+    // 写出压缩快照：条目按块做差分或前缀编码，codec不为none时每块再做通用压缩
+    void serialize_compressed(const std::string& path, SnapshotCodec codec = SnapshotCodec::none);
+    // num_threads个线程并行解压各块，再以同样的线程数批量构建，替换树的当前内容
+    void deserialize_compressed(const std::string& path, int num_threads = 1);
+
+    // 持久化模式：加载检查点base_filename.ckpt（若存在）及其后的增量检查点，再重放之后的日志段，
+    // 之后insert/remove在返回前先写日志。bulk_load与deserialize不写日志，之后需调用checkpoint
+    void open(const std::string& base_filename, const WalOptions& options = WalOptions());
+    // 在线写出检查点并删除已被覆盖的日志段，期间其他操作照常进行。
+    // 通常只写出上次检查点以来被修改的叶子，增量累计到WalOptions::max_checkpoint_deltas个时写全量
+    void checkpoint();
 
     void print_tree() const;
 };
\ No newline at end of file
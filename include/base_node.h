@@ -1,25 +1,66 @@
 #pragma once
 
-#include<vector>
+#include<atomic>
+#include<cstddef>
 #include<shared_mutex>
 
+#include"node_array.h"
+#include"string_key_array.h"
+
 template <typename Key>
 class BaseNode {
 public:
+    using KeyArray = typename NodeKeyArray<Key>::type;
+
     bool is_leaf;
+    int level;  // 叶子为0，向上逐层加1
     int size;
-    std::vector<Key> keys;
+    KeyArray keys;  // 存储区紧跟在派生节点对象之后
+    // 乐观锁版本号，奇数表示节点正在被修改
+    std::atomic<uint64_t> version;
+    // 分裂出的新节点在分隔键安装到父节点前为nullptr；计数模式下则指向将要安装到的父节点，
+    // 其键数已计入该父节点
     BaseNode* parent;
+    // B-link上界：节点只包含小于high_key的键，无上界时has_high_key为false
+    Key high_key;
+    bool has_high_key;
     mutable std::shared_mutex mutex;
+    // 子树中的键数，仅在计数模式下维护；写入方不加节点锁直接累加
+    std::atomic<int64_t> subtree_count;
 
-    BaseNode(bool is_leaf);
+    BaseNode(bool is_leaf, int order, void* key_storage);
     virtual ~BaseNode() = default;
 
+    // 节点对象与其定长数组分配在同一块按缓存行对齐的内存中，只能通过派生类的create创建
+    static void* operator new(std::size_t size, NodeBlock block);
+    static void operator delete(void* ptr, NodeBlock block);
+    static void operator delete(void* ptr);
+
     int find_index(const Key& key) const;
-    bool is_overloaded(int order) const;
-    bool is_underloaded(int order) const;
-    bool is_safe(int order) const;
+    // 容量判断定义在头文件中，调用方传入编译期阶数时可常量折叠
+    bool is_overloaded(int order) const { return size > order; }
+    bool is_underloaded(int order) const { return size < (order + 1) / 2; }
+    bool is_safe(int order) const { return (size < order) && (size > (order + 1) / 2); }
+    bool beyond_high_key(const Key& key) const;
+
+    // 写锁：加互斥锁并推进版本号
+    void write_lock();
+    void write_unlock();
+    bool try_write_lock();
+    // 仅推进版本号，不加互斥锁
+    void begin_write();
+    void end_write();
+    // 乐观读：等待写者结束并返回当前版本号，读取完成后用validate校验
+    uint64_t read_version() const;
+    bool validate(uint64_t read_version) const;
 
     virtual void insert_in_node(const Key& key, uint64_t value, BaseNode* right_child, int order) = 0;
     virtual void remove_from_node(int index, int order) = 0;
-};
\ No newline at end of file
+};
+
+// int键的节点内查找使用SIMD实现
+template <>
+int BaseNode<int>::find_index(const int& key) const;
+// std::string键先比较公共前缀和键头
+template <>
+int BaseNode<std::string>::find_index(const std::string& key) const;
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// 压缩快照中块编码之后的通用压缩算法
+enum class SnapshotCodec : uint8_t { none = 0, zlib = 1 };
+
+constexpr uint32_t COMPRESSED_SNAPSHOT_MAGIC = 0x43545042;  // "BPTC"
+// 每块包含的条目数上限
+constexpr uint32_t COMPRESSED_BLOCK_ENTRIES = 4096;
+
+// 压缩快照文件头，块目录位于所有块之后。快照只保存条目，与树的阶数无关
+struct CompressedSnapshotHeader {
+    uint32_t magic;
+    int32_t key_type;  // 0:int 1:string
+    uint32_t block_count;
+    uint32_t reserved;
+    uint64_t entry_count;
+    uint64_t directory;  // 块目录在文件中的偏移
+};
+
+// 块目录项，stored_size为文件中的字节数，raw_size为块编码后、通用压缩前的字节数
+struct CompressedBlockEntry {
+    uint64_t offset;
+    uint32_t stored_size;
+    uint32_t raw_size;
+    uint32_t entry_count;
+    uint8_t codec;
+    uint8_t reserved[3];
+};
+
+// 通用压缩算法是否已编译进来
+bool codec_available(SnapshotCodec codec);
+
+// 块编码：先所有键后所有值。int键首个为zigzag varint，之后为与前一个键之差的varint；
+// string键为前缀编码（与前一个键的公共前缀长度 + 后缀长度 + 后缀），每块从完整的键开始；值为varint
+template <typename Key>
+void encode_block(std::string& out, const std::vector<std::pair<Key, uint64_t>>& entries);
+// 解码count个条目到first开始的位置，数据损坏时抛出异常
+template <typename Key>
+void decode_block(const char* data, std::size_t size, std::pair<Key, uint64_t>* first, uint32_t count);
+
+// 通用压缩，结果不比原数据小时返回false，调用方按原样存储
+bool compress_block(SnapshotCodec codec, const std::string& raw, std::string& out);
+void decompress_block(SnapshotCodec codec, const char* data, std::size_t size, std::size_t raw_size,
+                      std::string& out);
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "page_file.h"
+
+class BufferPool;
+
+// 已固定（pin）页面的句柄，析构时解除固定。修改过页面内容后需调用mark_dirty
+class PageHandle {
+   public:
+    PageHandle() = default;
+    PageHandle(PageHandle&& other) noexcept;
+    PageHandle& operator=(PageHandle&& other) noexcept;
+    PageHandle(const PageHandle&) = delete;
+    PageHandle& operator=(const PageHandle&) = delete;
+    ~PageHandle();
+
+    char* data() const { return ptr; }
+    uint64_t id() const { return page_id; }
+    void mark_dirty() { dirty = true; }
+    // 提前解除固定
+    void release();
+
+   private:
+    friend class BufferPool;
+    PageHandle(BufferPool* pool, int frame, uint64_t page_id, char* ptr);
+
+    BufferPool* pool = nullptr;
+    int frame = -1;  // 直接映射模式下为-1
+    uint64_t page_id = PageFile::invalid_page;
+    char* ptr = nullptr;
+    bool dirty = false;
+};
+
+// 页缓冲池：固定数量的页帧，按CLOCK算法淘汰未固定的页，脏页在淘汰或flush时写回。
+// capacity为0时不做缓存，句柄直接指向页文件的映射（此时allocate会使已有句柄失效）
+class BufferPool {
+   public:
+    BufferPool(PageFile& file, std::size_t capacity);
+    ~BufferPool();
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    // 固定页面，所有页帧都被固定时抛出异常
+    PageHandle fetch(uint64_t id);
+    // 在文件末尾分配新页并固定，新页已标记为脏
+    PageHandle allocate();
+    // 写回所有脏页并同步到磁盘
+    void flush_all();
+
+    std::size_t capacity() const { return frames.size(); }
+    // 从文件读入页面的次数
+    uint64_t misses() const;
+
+   private:
+    friend class PageHandle;
+
+    struct Frame {
+        uint64_t page_id = PageFile::invalid_page;
+        int pin_count = 0;
+        bool dirty = false;
+        bool referenced = false;  // CLOCK引用位
+    };
+
+    char* frame_data(int frame) const { return buffer + static_cast<std::size_t>(frame) * PageFile::page_size; }
+    int evict();
+    void unpin(int frame, bool dirty);
+
+    PageFile& file;
+    std::vector<Frame> frames;
+    char* buffer;
+    std::unordered_map<uint64_t, int> page_table;
+    std::size_t clock_hand;
+    uint64_t miss_count;
+    mutable std::mutex mutex;
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 带大块缓冲的顺序文件写入器：小字段先编码进缓冲，缓冲写满时一次write写出。
+// 已写出的位置可用patch回填（在缓冲中直接修改，已落盘的部分用pwrite）
+class BufferedFileWriter {
+   public:
+    static constexpr std::size_t default_buffer_size = 4 << 20;
+
+    explicit BufferedFileWriter(const std::string& path, std::size_t buffer_size = default_buffer_size);
+    ~BufferedFileWriter();
+
+    BufferedFileWriter(const BufferedFileWriter&) = delete;
+    BufferedFileWriter& operator=(const BufferedFileWriter&) = delete;
+
+    void write(const void* data, std::size_t size);
+    template <typename T>
+    void put(const T& value) {
+        write(&value, sizeof(value));
+    }
+    // 已写入的总字节数（含缓冲中的部分）
+    uint64_t position() const { return flushed + buffer.size(); }
+    void patch(uint64_t position, const void* data, std::size_t size);
+
+    void flush();
+    // 写出缓冲并fsync
+    void sync();
+    // 写出缓冲并关闭文件（写出失败时也会关闭），析构时自动调用但不上报错误
+    void close();
+
+   private:
+    void write_all(const char* data, std::size_t size);
+
+    int fd;
+    std::vector<char> buffer;
+    std::size_t capacity;
+    uint64_t flushed;  // 已写入文件的字节数
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "buffer_pool.h"
+#include "page_file.h"
+
+// 磁盘模式的B+树：节点存放在mmap页文件的定长页中，子节点指针为页号。
+// 打开时只读取文件头，其余页面按访问情况换入，因此大树也能立即打开。
+// 页面访问都经过缓冲池的页句柄：pool_pages为0时直接使用mmap映射，由操作系统换页；
+// 大于0时最多在内存中缓存pool_pages个页面，内存占用与树的大小无关。
+// 节点容量由页大小和键宽度决定；std::string键按定长槽位存放，超长的键会被拒绝。
+// 读操作共享、写操作独占一把读写锁；删除不做合并，空出的页面留在原位。
+// 文件头中的根页号只在sync（及析构）写回所有节点页之后才更新，崩溃后不会指向尚未写出的页面。
+template <typename Key>
+class DiskBPlusTree {
+   private:
+    // 上层分裂后需要在父节点中插入的分隔键与新右兄弟页号
+    struct Split {
+        Key key;
+        uint64_t right;
+    };
+
+    mutable std::shared_mutex tree_mutex;
+    PageFile file;
+    mutable BufferPool pool;  // 析构时先于file写回脏页
+    uint64_t root;            // 当前根页号，sync时才写入文件头
+
+    uint64_t root_page() const;
+    void set_root_page(uint64_t id);
+    // 写回所有脏页后再把根页号写入文件头，调用方持有写锁
+    void publish_root();
+    PageHandle fetch_leaf(const Key& key) const;
+    std::optional<Split> insert_into(uint64_t page_id, const Key& key, uint64_t value);
+    std::optional<Split> split_leaf(uint64_t page_id, const Key& key, uint64_t value);
+    std::optional<Split> split_internal(uint64_t page_id, int index, const Split& child_split);
+
+   public:
+    // 打开已有的树文件或创建空树，键类型与文件不一致时抛出异常。
+    // pool_pages大于0时至少为4（分裂时会同时固定多个页面）
+    explicit DiskBPlusTree(const std::string& path, std::size_t pool_pages = 0);
+    ~DiskBPlusTree();
+
+    DiskBPlusTree(const DiskBPlusTree&) = delete;
+    DiskBPlusTree& operator=(const DiskBPlusTree&) = delete;
+
+    void insert(const Key& key, uint64_t value);
+    void remove(const Key& key);
+    // 键不存在时返回0
+    uint64_t find(const Key& key) const;
+    std::vector<std::pair<Key, uint64_t>> range_find(const Key& start, const Key& end) const;
+
+    // 将所有修改刷到磁盘，之后再更新文件头中的根页号
+    void sync();
+    // 缓冲池从文件读入页面的次数，直接映射模式下为0
+    uint64_t page_misses() const;
+
+    static int leaf_capacity();
+    static int internal_capacity();
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "thread_registry.h"
+
+// 基于epoch的延迟回收：
+// 操作开始时登记当前全局epoch，结束时清除；被摘除的节点记入本线程的回收列表并标记摘除时的epoch。
+// 全局epoch只有在所有活跃线程都已登记当前epoch时才能推进，因此摘除后epoch推进两次时，
+// 已不存在可能持有该节点指针的线程，此时才真正释放。
+// 回收列表攒够阈值时、以及线程带着待回收节点离开临界区时尝试推进epoch并回收本线程的列表。
+// 溢出槽位由各溢出线程轮流持有，其回收列表随槽位交接。
+class EpochManager {
+   public:
+    EpochManager();
+    ~EpochManager();
+
+    void enter();
+    void exit();
+
+    // 延迟释放ptr，必须在enter/exit之间调用
+    void retire(void* ptr, void (*deleter)(void*));
+    // 立即释放所有待回收节点，调用方需保证没有并发操作
+    void reclaim_all();
+
+   private:
+    struct Retired {
+        void* ptr;
+        void (*deleter)(void*);
+        uint64_t epoch;
+    };
+
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> epoch;  // 0表示不在临界区
+        int depth;                    // 嵌套深度，仅本线程访问
+        std::vector<Retired> retired;
+    };
+
+    bool try_advance();
+    void reclaim(Slot& slot);
+
+    std::atomic<uint64_t> global_epoch;
+    Slot slots[THREAD_SLOT_COUNT];
+};
+
+// 作用域内保持epoch登记
+class EpochGuard {
+   public:
+    explicit EpochGuard(EpochManager& manager) : manager(manager) { manager.enter(); }
+    ~EpochGuard() { manager.exit(); }
+
+    EpochGuard(const EpochGuard&) = delete;
+    EpochGuard& operator=(const EpochGuard&) = delete;
+
+   private:
+    EpochManager& manager;
+};
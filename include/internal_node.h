@@ -5,9 +5,11 @@
 template <typename Key>
 class InternalNode : public BaseNode<Key> {
 public:
-    std::vector<BaseNode<Key>*> children;
+    NodeArray<BaseNode<Key>*> children;
+    InternalNode* right;  // B-link右兄弟
 
-    InternalNode();
+    // 节点与键、子节点数组一次分配
+    static InternalNode* create(int order);
     ~InternalNode();
     
     void insert_in_node(const Key& key, uint64_t value, BaseNode<Key>* right_child, int order) override;
@@ -16,4 +18,9 @@ public:
     
     void borrow_from_left(int child_index, int order);
     void borrow_from_right(int child_index, int order);
+
+private:
+    explicit InternalNode(int order);
+    static std::size_t keys_offset();
+    static std::size_t children_offset(int order);
 };
\ No newline at end of file
@@ -5,12 +5,22 @@
 template <typename Key>
 class LeafNode : public BaseNode<Key> {
 public:
-    std::vector<uint64_t> values;
-    LeafNode* prev;
+    NodeArray<uint64_t> values;
+    // 前驱由相邻节点在各自的锁下修改，逆序扫描只持有当前叶子的锁读取，因此为原子指针
+    // （release写、acquire读）
+    std::atomic<LeafNode*> prev;
     LeafNode* next;
+    // 自上次检查点以来内容或区间是否改变（插入、删除、分裂、借用、合并），持有写锁时置位，由检查点清除
+    bool dirty;
 
-    LeafNode();
+    // 节点与键、值数组一次分配
+    static LeafNode* create(int order);
     void insert_in_node(const Key& key, uint64_t value, BaseNode<Key>* right_child, int order) override;
     void remove_from_node(int index, int order) override;
     LeafNode* split(int order);
+
+private:
+    explicit LeafNode(int order);
+    static std::size_t keys_offset();
+    static std::size_t values_offset(int order);
 };
\ No newline at end of file
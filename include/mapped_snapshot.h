@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+template <typename Key, int Order>
+class BPlusTree;
+
+// 可映射快照的文件格式（BPlusTree::serialize_mapped写出）：
+// 文件头之后节点按层自底向上连续存放，叶子在前、根在最后；子节点与下一叶子用文件内偏移表示，
+// 节点记录按8字节对齐，映射后可原地查找，无需解析
+constexpr uint64_t MAPPED_SNAPSHOT_MAGIC = 0x31504D5345455254ULL;  // "TREESMP1"
+
+struct MappedSnapshotHeader {
+    uint64_t magic;
+    int32_t key_type;  // 0:int 1:string
+    int32_t order;
+    uint64_t root;        // 根节点偏移，空树为0
+    uint64_t first_leaf;  // 第一个叶子偏移，空树为0
+    uint64_t entry_count;
+    uint64_t file_size;
+};
+
+// 节点记录：头部 + 键槽 + 值（叶子）或子节点偏移（内部节点，size+1个） + string键的内容
+struct MappedNodeHeader {
+    uint8_t is_leaf;
+    uint8_t reserved[3];
+    int32_t size;
+    uint64_t next;  // 叶子的下一叶子偏移，0表示没有
+};
+
+// string键的键槽，offset相对节点记录起始
+struct MappedStringSlot {
+    uint32_t offset;
+    uint32_t length;
+};
+
+template <typename Key>
+struct MappedNodeLayout {
+    static constexpr std::size_t slot_size = std::is_same<Key, int>::value ? sizeof(int32_t) : sizeof(MappedStringSlot);
+
+    static std::size_t align(std::size_t n) { return (n + 7) & ~static_cast<std::size_t>(7); }
+    // 值或子节点偏移数组的起始位置
+    static std::size_t array_offset(int size) { return align(sizeof(MappedNodeHeader) + slot_size * size); }
+    // 定长部分的大小，string键的内容紧随其后
+    static std::size_t fixed_size(bool is_leaf, int size) {
+        return array_offset(size) + sizeof(uint64_t) * (is_leaf ? size : size + 1);
+    }
+};
+
+// 只读映射快照：打开时只校验文件头，查找直接在映射上进行，由操作系统按需换入页面。
+// 第一次insert/remove时沿叶子链把全部条目批量构建为BPlusTree（按快照中的阶数），
+// 之后所有操作转到该树上，映射随即释放
+template <typename Key>
+class MappedSnapshot {
+   public:
+    explicit MappedSnapshot(const std::string& path);
+    ~MappedSnapshot();
+
+    MappedSnapshot(const MappedSnapshot&) = delete;
+    MappedSnapshot& operator=(const MappedSnapshot&) = delete;
+
+    // 键不存在时返回0
+    uint64_t find(const Key& key) const;
+    std::vector<std::pair<Key, uint64_t>> range_find(const Key& start, const Key& end) const;
+    size_t size() const;
+
+    void insert(const Key& key, uint64_t value);
+    void remove(const Key& key);
+    bool materialized() const;
+
+   private:
+    // 在映射上比较键时不构造std::string
+    using KeyView = std::conditional_t<std::is_same<Key, int>::value, int, std::string_view>;
+
+    const char* node(uint64_t offset) const { return data + offset; }
+    static int node_size(const char* node);
+    static KeyView key_at(const char* node, int index);
+    static uint64_t array_at(const char* node, int index);
+    static int lower_bound(const char* node, KeyView key);
+    static int upper_bound(const char* node, KeyView key);
+    const char* find_leaf(KeyView key) const;
+    BPlusTree<Key, 0>* writable();
+    void unmap();
+
+    const char* data;
+    std::size_t length;
+    MappedSnapshotHeader header;
+    // 物化前后切换时独占，其余操作共享
+    mutable std::shared_mutex mutex;
+    std::unique_ptr<BPlusTree<Key, 0>> tree;
+};
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+// 节点内的定长数组：存储区由节点在同一块内存中提供，容量在创建时确定，不会扩容
+// 接口与std::vector相同的子集，已构造的元素为[0, size())
+template <typename T>
+class NodeArray {
+   public:
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    static std::size_t storage_bytes(int capacity) { return sizeof(T) * capacity; }
+    static constexpr std::size_t storage_alignment = alignof(T);
+
+    NodeArray(void* storage, int capacity) : items(static_cast<T*>(storage)), count(0), cap(capacity) {}
+    ~NodeArray() { clear(); }
+
+    NodeArray(const NodeArray&) = delete;
+    NodeArray& operator=(const NodeArray&) = delete;
+
+    int size() const { return count; }
+    int capacity() const { return cap; }
+    bool empty() const { return count == 0; }
+
+    iterator begin() { return items; }
+    iterator end() { return items + count; }
+    const_iterator begin() const { return items; }
+    const_iterator end() const { return items + count; }
+
+    T& operator[](int index) { return items[index]; }
+    const T& operator[](int index) const { return items[index]; }
+    T& back() { return items[count - 1]; }
+    const T& back() const { return items[count - 1]; }
+    bool equals(int index, const T& value) const { return items[index] == value; }
+
+    void set(int index, T value) {
+        items[index] = std::move(value);
+    }
+
+    void push_back(T value) {
+        check_room(1);
+        new (items + count) T(std::move(value));
+        count++;
+    }
+
+    void pop_back() {
+        items[--count].~T();
+    }
+
+    iterator insert(const_iterator pos, T value) {
+        check_room(1);
+        T* target = const_cast<T*>(pos);
+        if (target == end()) {
+            new (end()) T(std::move(value));
+        } else {
+            new (end()) T(std::move(back()));
+            std::move_backward(target, end() - 1, end());
+            *target = std::move(value);
+        }
+        count++;
+        return target;
+    }
+
+    template <typename InputIt>
+    iterator insert(const_iterator pos, InputIt first, InputIt last) {
+        int offset = pos - items;
+        int old_count = count;
+        check_room(static_cast<int>(std::distance(first, last)));
+        for (; first != last; ++first) {
+            new (items + count) T(*first);
+            count++;
+        }
+        // 先追加到末尾再旋转到目标位置
+        std::rotate(items + offset, items + old_count, items + count);
+        return items + offset;
+    }
+
+    iterator erase(const_iterator pos) {
+        return erase(pos, pos + 1);
+    }
+
+    iterator erase(const_iterator first, const_iterator last) {
+        T* target = const_cast<T*>(first);
+        int removed = last - first;
+        std::move(const_cast<T*>(last), end(), target);
+        for (int i = count - removed; i < count; i++) {
+            items[i].~T();
+        }
+        count -= removed;
+        return target;
+    }
+
+    template <typename InputIt>
+    void assign(InputIt first, InputIt last) {
+        clear();
+        insert(end(), first, last);
+    }
+
+    void resize(int new_count) {
+        if (new_count < count) {
+            for (int i = new_count; i < count; i++) {
+                items[i].~T();
+            }
+            count = new_count;
+        } else {
+            check_room(new_count - count);
+            for (; count < new_count; count++) {
+                new (items + count) T();
+            }
+        }
+    }
+
+    void clear() {
+        for (int i = 0; i < count; i++) {
+            items[i].~T();
+        }
+        count = 0;
+    }
+
+   private:
+    void check_room(int extra) const {
+        if (count + extra > cap) {
+            throw std::runtime_error("Node capacity exceeded");
+        }
+    }
+
+    T* items;
+    int count;
+    int cap;
+};
+
+// 节点键数组的类型，可按键类型特化
+template <typename Key>
+struct NodeKeyArray {
+    using type = NodeArray<Key>;
+};
+
+// 节点内存块的描述：节点对象之后紧跟各定长数组
+struct NodeBlock {
+    std::size_t bytes;
+};
+
+inline std::size_t node_align_up(std::size_t offset, std::size_t alignment) {
+    return (offset + alignment - 1) / alignment * alignment;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+
+#include "thread_registry.h"
+
+// 操作闸门：代替全树读写锁。
+// 普通操作（lock_shared）只修改本线程槽位的计数器，不与其他线程争用同一缓存行；
+// 序列化等需要独占整棵树的操作（lock）关闭闸门，并等待所有槽位上的操作退出。
+// 接口与std::shared_mutex一致，可直接配合std::shared_lock/std::unique_lock使用。
+class OperationGate {
+   public:
+    OperationGate();
+
+    void lock_shared();
+    void unlock_shared();
+
+    void lock();
+    void unlock();
+
+   private:
+    struct alignas(64) Slot {
+        std::atomic<int> active;
+    };
+
+    Slot slots[THREAD_SLOT_COUNT];
+    std::atomic<bool> closed;
+    std::mutex exclusive_mutex;  // 独占方之间互斥
+};
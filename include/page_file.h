@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// 定长页文件：整个文件通过mmap映射到内存，按页号访问。
+// 第0页是文件头，头部之后的空间（user_meta）留给上层保存根页号等元数据。
+// 文件扩展时会重新映射，之前通过page()取得的指针随之失效，调用方需在allocate()之后重新取页。
+class PageFile {
+   public:
+    static constexpr uint32_t page_size = 4096;
+    static constexpr uint64_t invalid_page = 0;  // 第0页是文件头，不会作为数据页
+
+    // 打开已有文件或创建新文件
+    explicit PageFile(const std::string& path);
+    ~PageFile();
+
+    PageFile(const PageFile&) = delete;
+    PageFile& operator=(const PageFile&) = delete;
+
+    char* page(uint64_t id) const;
+    // 在文件末尾追加一页并返回页号，新页内容全为0
+    uint64_t allocate();
+    uint64_t page_count() const;
+
+    // 不经过映射，直接读写整页（供缓冲池使用）
+    void read_page(uint64_t id, char* buffer) const;
+    void write_page(uint64_t id, const char* buffer);
+
+    // 文件头之后可由上层使用的元数据区
+    char* user_meta() const;
+    static constexpr std::size_t user_meta_size = page_size - 64;
+
+    // 将映射中的修改同步到磁盘
+    void sync();
+
+   private:
+    struct Header {
+        uint64_t magic;
+        uint32_t page_size;
+        uint32_t reserved;
+        uint64_t page_count;
+    };
+
+    Header* header() const;
+    void map(uint64_t capacity);
+
+    int fd;
+    char* data;
+    uint64_t capacity;  // 已映射的页数，不小于page_count
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+template <typename Key, int Order>
+class BPlusTree;
+
+// 范围游标：按批从叶子链复制条目，批与批之间不持有任何锁。
+// 下一批从上一批最后一个键之后（逆序时为之前）重新定位，期间的并发修改不会导致重复返回或回退
+template <typename Key, int Order = 0>
+class RangeCursor {
+   public:
+    bool valid() const { return position < batch.size(); }
+    const Key& key() const { return batch[position].first; }
+    uint64_t value() const { return batch[position].second; }
+    void next();
+
+   private:
+    friend class BPlusTree<Key, Order>;
+    RangeCursor(const BPlusTree<Key, Order>* tree, const Key& start, bool reverse);
+
+    const BPlusTree<Key, Order>* tree;
+    bool reverse;
+    std::vector<std::pair<Key, uint64_t>> batch;
+    std::size_t position;
+};
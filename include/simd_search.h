@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+
+// 有序整数数组内的下界查找：先二分缩小到几个向量宽度，再用SIMD一次比较多个键并统计小于key的个数。
+// 首次调用时按CPU特性选择AVX2、SSE或标量实现
+int simd_lower_bound(const int32_t* keys, int size, int32_t key);
+int simd_lower_bound(const int64_t* keys, int size, int64_t key);
+
+// 当前选用的实现名称（"avx2"、"sse"或"scalar"）
+const char* simd_search_variant();
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+
+#include "node_array.h"
+
+// std::string键的节点数组：节点内所有键的公共前缀只存一份，各键只保存去掉前缀后的后缀，
+// 后缀按顺序紧凑存放在同一块字节区中，ends[i]为第i个后缀的结束偏移。
+// 每个键另有定长的键头，即后缀的前8个字节（大端序，不足补0，比较顺序与原字符串一致）。
+// 查找时先比较公共前缀，再在键头上做整数二分，只有键头相同时才比较后缀。
+// 键不以std::string的形式存放，下标访问和迭代器按值返回拼接出的完整键
+class StringKeyArray {
+   public:
+    // 只读随机访问迭代器，解引用得到完整键
+    class const_iterator {
+       public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = std::string;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = std::string;
+
+        const_iterator(const StringKeyArray* array, int index) : array(array), index(index) {}
+
+        std::string operator*() const { return (*array)[index]; }
+        const_iterator& operator++() {
+            index++;
+            return *this;
+        }
+        const_iterator operator+(int n) const { return const_iterator(array, index + n); }
+        const_iterator operator-(int n) const { return const_iterator(array, index - n); }
+        difference_type operator-(const const_iterator& other) const { return index - other.index; }
+        bool operator==(const const_iterator& other) const { return array == other.array && index == other.index; }
+        bool operator!=(const const_iterator& other) const { return !(*this == other); }
+
+       private:
+        friend class StringKeyArray;
+        const StringKeyArray* array;
+        int index;
+    };
+    using iterator = const_iterator;
+
+    static std::size_t storage_bytes(int capacity);
+    static constexpr std::size_t storage_alignment = alignof(int64_t);
+
+    StringKeyArray(void* storage, int capacity);
+
+    StringKeyArray(const StringKeyArray&) = delete;
+    StringKeyArray& operator=(const StringKeyArray&) = delete;
+
+    int size() const { return count; }
+    int capacity() const { return cap; }
+    bool empty() const { return count == 0; }
+    int prefix_length() const { return prefix.size(); }
+    // 后缀区的字节数
+    std::size_t suffix_bytes() const { return suffixes.size(); }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, count); }
+    std::string operator[](int index) const;
+    std::string back() const { return (*this)[count - 1]; }
+    // 不拼接完整键，直接与后缀比较
+    bool equals(int index, const std::string& key) const;
+
+    void set(int index, const std::string& value);
+    void push_back(const std::string& value);
+    void pop_back();
+    const_iterator insert(const_iterator pos, const std::string& value);
+    const_iterator insert(const_iterator pos, const_iterator first, const_iterator last);
+    const_iterator erase(const_iterator pos);
+    const_iterator erase(const_iterator first, const_iterator last);
+    void assign(const_iterator first, const_iterator last);
+    void resize(int new_count);
+    void clear();
+
+    // 第一个不小于key的位置
+    int lower_bound(const std::string& key) const;
+
+   private:
+    uint32_t suffix_begin(int index) const { return index == 0 ? 0 : ends[index - 1]; }
+    uint32_t suffix_length(int index) const { return ends[index] - suffix_begin(index); }
+    static int64_t head_of(const char* suffix, std::size_t length);
+    void shrink_prefix(std::size_t length);
+    void rebuild(const std::string* keys, int n);
+
+    std::string prefix;
+    std::string suffixes;
+    int64_t* heads;  // 符号位取反，使有符号比较与无符号字节序一致
+    uint32_t* ends;
+    int count;
+    int cap;
+};
+
+template <>
+struct NodeKeyArray<std::string> {
+    using type = StringKeyArray;
+};
@@ -0,0 +1,17 @@
+#pragma once
+
+// 线程槽位上限，每棵树按槽位为线程保留独立的缓存行
+constexpr int MAX_THREAD_SLOTS = 256;
+// 槽位用尽后其余线程共用的溢出槽位，同一时刻只由一个线程持有
+constexpr int OVERFLOW_THREAD_SLOT = MAX_THREAD_SLOTS;
+// 按槽位分配的数组长度，包含溢出槽位
+constexpr int THREAD_SLOT_COUNT = MAX_THREAD_SLOTS + 1;
+
+// 操作开始时领取槽位，返回槽位编号，与release_thread_slot成对调用，可嵌套。
+// 线程首次调用时领取独占槽位，线程退出时归还，全进程内唯一；没有空闲槽位时
+// 使用溢出槽位，各溢出线程的最外层操作之间互斥（慢路径），下次操作时再尝试领取独占槽位
+int acquire_thread_slot();
+void release_thread_slot();
+
+// 当前线程正在使用的槽位编号，只能在acquire_thread_slot与release_thread_slot之间调用
+int current_thread_slot();
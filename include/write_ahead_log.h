@@ -0,0 +1,67 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+
+struct WalOptions {
+    // true：提交时等待记录fsync完成，并发提交的记录合并为一次fsync（组提交）；
+    // false：记录先留在缓冲中，缓冲写满或flush时才写入文件，崩溃时可能丢失最近的记录
+    bool sync_commit = true;
+    // 组提交的领导者在刷盘前最多等待的时间，以便更多记录搭车，为0时不等待
+    std::chrono::microseconds group_commit_delay{0};
+    // 待提交记录达到该数量时领导者立即刷盘
+    std::size_t group_commit_size = 64;
+    // 非同步提交时的缓冲大小
+    std::size_t buffer_size = 1 << 16;
+    // 全量检查点之上最多累积的增量检查点数，达到后下一次检查点写全量（为0时总是写全量）
+    std::size_t max_checkpoint_deltas = 8;
+};
+
+// 预写日志：记录为[长度][CRC32][内容]，追加写入单个文件。
+// append只把记录放入内存缓冲并返回序号；wait_durable等待该序号之前的记录落盘，
+// 同一时刻只有一个线程（领导者）写文件并fsync，其余线程等待其结果。
+// 写文件或fsync失败后日志进入错误状态：失败批次中的记录不会被视为已落盘，
+// 之后的append、wait_durable、flush和rotate都重新抛出该错误
+class WriteAheadLog {
+   public:
+    WriteAheadLog(const std::string& path, const WalOptions& options);
+    ~WriteAheadLog();
+
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    uint64_t append(const char* data, std::size_t size);
+    // sync_commit为false时立即返回
+    void wait_durable(uint64_t lsn);
+    // 写出缓冲中的所有记录并fsync
+    void flush();
+    // 写出并同步当前文件中的记录，之后的记录追加到new_path（新建时同步其所在目录）。切换期间追加会短暂等待
+    void rotate(const std::string& new_path);
+
+    // 按顺序回放path中的完整记录，遇到被截断或校验失败的记录即停止并截掉其后的内容；
+    // 文件不存在时不做任何事
+    static void replay(const std::string& path, const std::function<void(const char*, std::size_t)>& apply);
+    // 将已写入的普通文件同步到磁盘
+    static void sync_file(const std::string& path);
+    // 同步path所在的目录，使其中新建、改名或删除的目录项持久化
+    static void sync_directory(const std::string& path);
+
+   private:
+    void write_out(std::unique_lock<std::mutex>& lock, bool sync);
+
+    int fd;
+    WalOptions options;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::string buffer;
+    uint64_t appended_lsn;  // 最后一条追加的记录序号
+    uint64_t durable_lsn;   // 已写出（同步模式下已fsync）的最大序号
+    bool writing;           // 领导者正在写文件
+    std::exception_ptr error;  // 第一次写出失败的错误
+};
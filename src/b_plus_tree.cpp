@@ -1,251 +1,1051 @@
 #include "b_plus_tree.h"
+#include "mapped_snapshot.h"
+
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <limits>
+
+namespace {
+
+// 日志记录类型
+constexpr char WAL_INSERT = 1;
+constexpr char WAL_REMOVE = 2;
+
+// 把[0, count)均分给threads个线程，最后一块在当前线程执行；各线程的异常在汇合后重新抛出
+void run_parallel(int threads, int32_t count, const std::function<void(int32_t, int32_t)>& work) {
+    std::vector<std::thread> workers;
+    std::vector<std::exception_ptr> errors(threads);
+    for (int t = 0; t < threads; t++) {
+        int32_t begin = static_cast<int32_t>(static_cast<int64_t>(count) * t / threads);
+        int32_t end = static_cast<int32_t>(static_cast<int64_t>(count) * (t + 1) / threads);
+        auto task = [&, t, begin, end] {
+            try {
+                work(begin, end);
+            } catch (...) {
+                errors[t] = std::current_exception();
+            }
+        };
+        if (t + 1 == threads)
+            task();
+        else
+            workers.emplace_back(task);
+    }
+    for (auto& worker : workers) worker.join();
+    for (auto& error : errors) {
+        if (error) std::rethrow_exception(error);
+    }
+}
 
-template <typename Key>
-BPlusTree<Key>::BPlusTree(int order) : order(order), root(nullptr), head_leaf(nullptr) {}
+// 批量构建时把count个元素（或子节点）均分到若干节点：节点大小尽量接近fill，且不超过max_size；
+// 节点多于一个时每个不少于min_size。两者无法同时满足时（奇数阶的内部层）优先保证不过载
+long long bulk_node_count(long long count, int fill, int min_size, int max_size) {
+    long long nodes = std::min((count + fill - 1) / fill, count / min_size);
+    nodes = std::max(nodes, (count + max_size - 1) / max_size);
+    return std::max(nodes, 1LL);
+}
 
+// 把节点编码为可映射快照中的记录，below为下一层节点的偏移，child为下一个未使用的下标
 template <typename Key>
-BPlusTree<Key>::~BPlusTree() {
-    delete root;
+void encode_mapped_node(std::string& record, const BaseNode<Key>* node, const std::vector<uint64_t>& below,
+                        size_t& child) {
+    using Layout = MappedNodeLayout<Key>;
+    int size = node->size;
+    record.assign(Layout::fixed_size(node->is_leaf, size), '\0');
+
+    MappedNodeHeader header{};
+    header.is_leaf = node->is_leaf;
+    header.size = size;
+    std::memcpy(&record[0], &header, sizeof(header));
+
+    char* slots = &record[sizeof(MappedNodeHeader)];
+    for (int i = 0; i < size; i++) {
+        if constexpr (std::is_same<Key, int>::value) {
+            int32_t key = node->keys[i];
+            std::memcpy(slots + i * sizeof(key), &key, sizeof(key));
+        } else {
+            const std::string& key = node->keys[i];
+            MappedStringSlot slot{static_cast<uint32_t>(record.size()), static_cast<uint32_t>(key.size())};
+            record.append(key);
+            slots = &record[sizeof(MappedNodeHeader)];  // append可能重新分配
+            std::memcpy(slots + i * sizeof(slot), &slot, sizeof(slot));
+        }
+    }
+    record.resize(Layout::align(record.size()), '\0');
+
+    uint64_t* array = reinterpret_cast<uint64_t*>(&record[Layout::array_offset(size)]);
+    if (node->is_leaf) {
+        const LeafNode<Key>* leaf = static_cast<const LeafNode<Key>*>(node);
+        for (int i = 0; i < size; i++) array[i] = leaf->values[i];
+    } else {
+        for (int i = 0; i <= size; i++) array[i] = below[child++];
+    }
 }
 
-template <typename Key>
-void BPlusTree<Key>::insert(const Key& key, uint64_t value) {
-    std::shared_lock<std::shared_mutex> lock(tree_mutex);
+}  // namespace
 
-    //保护根节点
-    root_mutex.lock();
-    if (!root) {
-        root = new LeafNode<Key>();
-        head_leaf = static_cast<LeafNode<Key>*>(root);
+template <typename Key, int Order>
+BPlusTree<Key, Order>::BPlusTree(int order, bool counted)
+    : order(order), root(nullptr), head_leaf(nullptr), counted(counted), count_version(0) {
+    if (order <= 0) {
+        throw std::runtime_error("Order must be positive");
+    }
+    if (Order > 0 && order != Order) {
+        throw std::runtime_error("Order does not match the compile-time order");
     }
+}
 
+template <typename Key, int Order>
+BPlusTree<Key, Order>::~BPlusTree() {
+    delete root.load();
+}
 
-    // 查找叶子节点并获取锁
-    std::queue<BaseNode<Key>*> unique_locked_queue;  //加了写锁的祖先节点
-    LeafNode<Key>* leaf = find_leaf(key, unique_locked_queue, true);
+template <typename Key, int Order>
+void BPlusTree<Key, Order>::insert(const Key& key, uint64_t value) {
+    std::shared_lock<OperationGate> lock(tree_gate);
+    EpochGuard guard(epoch_manager);
+    ensure_root();
+
+    // 只对目标叶子节点加写锁，祖先节点不加锁
+    LeafNode<Key>* leaf = static_cast<LeafNode<Key>*>(lock_node(key, 0));
+
+    // 日志在持有叶子锁时、修改节点之前追加，保证同一键的日志顺序与修改顺序一致；
+    // 追加失败时节点未被修改，释放锁后上抛
+    uint64_t lsn;
+    try {
+        lsn = log_write(WAL_INSERT, key, value);
+    } catch (...) {
+        leaf->write_unlock();
+        throw;
+    }
+    int size = leaf->size;
+    leaf->insert_in_node(key, value, nullptr, node_order());
+    add_count(leaf, leaf->size - size);
 
-    // 插入操作
-    leaf->insert_in_node(key, value, nullptr, order);
+    // 处理分裂（内部负责释放锁）
+    if (leaf->is_overloaded(node_order())) {
+        handle_split(leaf);
+    } else {
+        leaf->write_unlock();
+    }
+    // 等待日志落盘时不阻塞其他写操作
+    log_commit(lsn);
+}
 
-    // 处理分裂
-    handle_split(leaf);
+// 批量插入：按键排序后每个目标叶子只下降和加锁一次，
+// 落在同一叶子的连续键在一次加锁内写入，叶子过载时分裂并从下一个键重新定位
+template <typename Key, int Order>
+void BPlusTree<Key, Order>::insert_batch(std::vector<std::pair<Key, uint64_t>> batch) {
+    if (batch.empty()) return;
+
+    // 稳定排序，重复键按原顺序写入，保留最后一个值
+    std::stable_sort(batch.begin(), batch.end(),
+                     [](const std::pair<Key, uint64_t>& a, const std::pair<Key, uint64_t>& b) { return a.first < b.first; });
+
+    std::shared_lock<OperationGate> lock(tree_gate);
+    EpochGuard guard(epoch_manager);
+    ensure_root();
+
+    size_t i = 0;
+    uint64_t lsn = 0;
+    while (i < batch.size()) {
+        LeafNode<Key>* leaf = static_cast<LeafNode<Key>*>(lock_node(batch[i].first, 0));
+        int size = leaf->size;
+        // 键有序，只需检查上界
+        do {
+            try {
+                lsn = std::max(lsn, log_write(WAL_INSERT, batch[i].first, batch[i].second));
+            } catch (...) {
+                // 本批之前的键已写入并记录日志，照常保留
+                add_count(leaf, leaf->size - size);
+                leaf->write_unlock();
+                throw;
+            }
+            leaf->insert_in_node(batch[i].first, batch[i].second, nullptr, node_order());
+            i++;
+        } while (i < batch.size() && !leaf->is_overloaded(node_order()) && !leaf->beyond_high_key(batch[i].first));
+        add_count(leaf, leaf->size - size);
 
+        if (leaf->is_overloaded(node_order())) {
+            handle_split(leaf);
+        } else {
+            leaf->write_unlock();
+        }
+    }
+    log_commit(lsn);
+}
 
-    // 释放锁
-    // leaf->mutex.unlock();
+template <typename Key, int Order>
+size_t BPlusTree<Key, Order>::range_count(const Key& start, const Key& end) const {
+    if (!counted) return range_aggregate(start, end).count;
+    if (end < start) return 0;
 
-    BaseNode<Key>* parent;
-    while (!unique_locked_queue.empty()) {
-        parent = unique_locked_queue.front();  //从最上层开始释放
-        if (parent == root) root_mutex.unlock();
-        unique_locked_queue.pop();
-        parent->mutex.unlock();
+    std::shared_lock<OperationGate> lock(tree_gate);
+    EpochGuard guard(epoch_manager);
+    while (true) {
+        uint64_t version = read_count_version();
+        int64_t count = count_before(end, true) - count_before(start, false);
+        // 两次下降之间的并发插入删除可能使差值暂时为负
+        if (validate_count_version(version)) return std::max<int64_t>(0, count);
     }
+}
+
+template <typename Key, int Order>
+uint64_t BPlusTree<Key, Order>::range_sum(const Key& start, const Key& end) const {
+    return range_aggregate(start, end).sum;
+}
+
+// 逐叶归约：先用二分确定每个叶子内落在范围中的区间，再直接遍历values
+template <typename Key, int Order>
+RangeAggregate BPlusTree<Key, Order>::range_aggregate(const Key& start, const Key& end) const {
+    std::shared_lock<OperationGate> lock(tree_gate);
+    EpochGuard guard(epoch_manager);
 
-    // std::cout << std::this_thread::get_id() << std::endl;
-    // print_tree();
+    RangeAggregate result;
+    if (end < start) return result;
+    LeafNode<Key>* current = lock_leaf_shared(start);
+    if (!current) return result;
+    int begin = current->find_index(start);
+
+    while (current) {
+        int finish = current->find_index(end);
+        if (finish < current->size && current->keys.equals(finish, end)) finish++;
+        const uint64_t* values = current->values.begin();
+        for (int i = begin; i < finish; i++) {
+            result.sum += values[i];
+            result.min = std::min(result.min, values[i]);
+            result.max = std::max(result.max, values[i]);
+        }
+        result.count += std::max(0, finish - begin);
 
-    // std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        // 范围在本叶子内结束
+        LeafNode<Key>* next = finish < current->size ? nullptr : current->next;
+        if (next) next->mutex.lock_shared();
+        current->mutex.unlock_shared();
+        begin = 0;
+        current = next;
+    }
+    return result;
 }
 
+template <typename Key, int Order>
+void BPlusTree<Key, Order>::range_visit(const Key& start, const Key& end,
+                                        const std::function<bool(const Key&, uint64_t)>& visitor) const {
+    std::shared_lock<OperationGate> lock(tree_gate);
+    EpochGuard guard(epoch_manager);
 
-template <typename Key>
-uint64_t BPlusTree<Key>::find(const Key& key) const {
-    std::shared_lock<std::shared_mutex> lock(tree_mutex);
-    root_mutex.lock_shared();
-    if (!root) return 0;
+    if (end < start) return;
+    LeafNode<Key>* current = lock_leaf_shared(start);
+    if (!current) return;
+    int begin = current->find_index(start);
+
+    while (current) {
+        for (int i = begin; i < current->size; i++) {
+            if (end < current->keys[i] || !visitor(current->keys[i], current->values[i])) {
+                current->mutex.unlock_shared();
+                return;
+            }
+        }
+        LeafNode<Key>* next = current->next;
+        if (next) next->mutex.lock_shared();
+        current->mutex.unlock_shared();
+        begin = 0;
+        current = next;
+    }
+}
+
+template <typename Key, int Order>
+size_t BPlusTree<Key, Order>::size() const {
+    std::shared_lock<OperationGate> lock(tree_gate);
+    EpochGuard guard(epoch_manager);
+    if (counted) {
+        BaseNode<Key>* node = root.load();
+        return node ? std::max<int64_t>(0, node->subtree_count.load(std::memory_order_relaxed)) : 0;
+    }
+
+    size_t count = 0;
+    LeafNode<Key>* current = head_leaf.load();
+    if (current) current->mutex.lock_shared();
+    while (current) {
+        count += current->size;
+        LeafNode<Key>* next = current->next;
+        if (next) next->mutex.lock_shared();
+        current->mutex.unlock_shared();
+        current = next;
+    }
+    return count;
+}
+
+template <typename Key, int Order>
+size_t BPlusTree<Key, Order>::rank(const Key& key) const {
+    std::shared_lock<OperationGate> lock(tree_gate);
+    EpochGuard guard(epoch_manager);
+    if (counted) {
+        while (true) {
+            uint64_t version = read_count_version();
+            int64_t count = count_before(key, false);
+            if (validate_count_version(version)) return count;
+        }
+    }
+
+    // 从头叶子开始沿叶子链计数
+    size_t count = 0;
+    LeafNode<Key>* current = head_leaf.load();
+    if (current) current->mutex.lock_shared();
+    while (current) {
+        int index = current->find_index(key);
+        count += index;
+        LeafNode<Key>* next = index < current->size ? nullptr : current->next;
+        if (next) next->mutex.lock_shared();
+        current->mutex.unlock_shared();
+        current = next;
+    }
+    return count;
+}
+
+template <typename Key, int Order>
+std::pair<Key, uint64_t> BPlusTree<Key, Order>::select(size_t k) const {
+    std::shared_lock<OperationGate> lock(tree_gate);
+    EpochGuard guard(epoch_manager);
+
+    while (true) {
+        uint64_t version = read_count_version();
+        size_t index = k;
+        LeafNode<Key>* leaf = select_leaf(index);
+        if (!leaf) {
+            if (!validate_count_version(version)) continue;
+            throw std::runtime_error("Select position out of range");
+        }
+        std::pair<Key, uint64_t> result(leaf->keys[index], leaf->values[index]);
+        leaf->mutex.unlock_shared();
+        if (validate_count_version(version)) return result;
+    }
+}
+
+// 定位第k小的键所在叶子并加共享锁，返回时k为叶子内下标；越界时返回nullptr。
+// 计数模式下按子树键数逐层交接共享锁下降，否则从头叶子开始；最后都沿叶子链跳过整叶，
+// 并发写入使计数暂时偏离时由此修正到实际位置
+template <typename Key, int Order>
+LeafNode<Key>* BPlusTree<Key, Order>::select_leaf(size_t& k) const {
+    BaseNode<Key>* node = nullptr;
+    if (counted) {
+        node = lock_root_shared();
+        if (!node) return nullptr;
+        while (!node->is_leaf) {
+            InternalNode<Key>* inode = static_cast<InternalNode<Key>*>(node);
+            int index = 0;
+            for (; index < inode->size; index++) {
+                int64_t count = std::max<int64_t>(0, inode->children[index]->subtree_count.load(std::memory_order_relaxed));
+                if (k < static_cast<size_t>(count)) break;
+                k -= count;
+            }
+            BaseNode<Key>* child = inode->children[index];
+            child->mutex.lock_shared();
+            node->mutex.unlock_shared();
+            node = child;
+        }
+    } else {
+        node = head_leaf.load();
+        if (!node) return nullptr;
+        node->mutex.lock_shared();
+    }
+
+    LeafNode<Key>* current = static_cast<LeafNode<Key>*>(node);
+    while (k >= static_cast<size_t>(current->size)) {
+        k -= current->size;
+        LeafNode<Key>* next = current->next;
+        if (next) next->mutex.lock_shared();
+        current->mutex.unlock_shared();
+        if (!next) return nullptr;
+        current = next;
+    }
+    return current;
+}
+
+// 小于key（inclusive时为不大于key）的键数：逐层交接共享锁下降，累加目标子节点左侧兄弟的子树键数，
+// 左侧兄弟与下一个兄弟之间尚未安装的分裂节点一并累加（持有父节点锁，下一个兄弟不会被摘除）；
+// 目标键已在尚未安装的分裂节点中时，经过的节点的键都小于key，累加后沿右链接右移
+template <typename Key, int Order>
+int64_t BPlusTree<Key, Order>::count_before(const Key& key, bool inclusive) const {
+    BaseNode<Key>* node = lock_root_shared();
+    if (!node) return 0;
+
+    int64_t count = 0;
+    while (true) {
+        while (node->beyond_high_key(key)) {
+            count += node->subtree_count.load(std::memory_order_relaxed);
+            BaseNode<Key>* right = right_link(node);
+            right->mutex.lock_shared();
+            node->mutex.unlock_shared();
+            node = right;
+        }
+        if (node->is_leaf) break;
+
+        InternalNode<Key>* inode = static_cast<InternalNode<Key>*>(node);
+        int index = inode->find_index(key);
+        if (index < inode->size && inode->keys.equals(index, key)) index++;
+        for (int i = 0; i < index; i++) {
+            for (BaseNode<Key>* sibling = inode->children[i]; sibling != inode->children[i + 1];
+                 sibling = right_link(sibling)) {
+                count += sibling->subtree_count.load(std::memory_order_relaxed);
+            }
+        }
+        BaseNode<Key>* child = inode->children[index];
+        child->mutex.lock_shared();
+        node->mutex.unlock_shared();
+        node = child;
+    }
+    int index = node->find_index(key);
+    if (inclusive && index < node->size && node->keys.equals(index, key)) index++;
+    node->mutex.unlock_shared();
+    return count + index;
+}
+
+// 计数模式下把叶子键数的变化累加到叶子及其所有祖先（调用方持有叶子写锁）。
+// 持有count_mutex共享锁期间父指针不会被改写，结构调整也看不到只累加了一半的路径
+template <typename Key, int Order>
+void BPlusTree<Key, Order>::add_count(BaseNode<Key>* node, int64_t delta) {
+    if (!counted || delta == 0) return;
+    std::shared_lock<std::shared_mutex> count_lock(count_mutex);
+    for (; node; node = node->parent) {
+        node->subtree_count.fetch_add(delta, std::memory_order_relaxed);
+    }
+}
+
+// 计数模式下开始结构调整：持有count_mutex独占锁，count_version变为奇数
+template <typename Key, int Order>
+void BPlusTree<Key, Order>::begin_count_change(std::unique_lock<std::shared_mutex>& count_lock) {
+    if (!counted) return;
+    count_lock.lock();
+    count_version.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+template <typename Key, int Order>
+void BPlusTree<Key, Order>::end_count_change(std::unique_lock<std::shared_mutex>& count_lock) {
+    if (!count_lock.owns_lock()) return;
+    count_version.fetch_add(1, std::memory_order_release);
+    count_lock.unlock();
+}
+
+// 读取方按计数下降前取得版本号（等待进行中的结构调整结束），下降后校验，不一致时重试
+template <typename Key, int Order>
+uint64_t BPlusTree<Key, Order>::read_count_version() const {
+    uint64_t version = count_version.load(std::memory_order_acquire);
+    while (version & 1) {
+        std::this_thread::yield();
+        version = count_version.load(std::memory_order_acquire);
+    }
+    return version;
+}
+
+template <typename Key, int Order>
+bool BPlusTree<Key, Order>::validate_count_version(uint64_t version) const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return count_version.load(std::memory_order_relaxed) == version;
+}
+
+// child已移到新的父节点（child->parent）后，其右侧尚未安装、父指针仍为from的分裂节点随之移动，
+// 遇到stop时停止。返回随child一起移动的键数（持有count_mutex独占锁）
+template <typename Key, int Order>
+int64_t BPlusTree<Key, Order>::adopt_split_chain(BaseNode<Key>* child, BaseNode<Key>* from, BaseNode<Key>* stop) {
+    int64_t count = child->subtree_count.load(std::memory_order_relaxed);
+    for (BaseNode<Key>* node = right_link(child); node && node != stop && node->parent == from;
+         node = right_link(node)) {
+        node->parent = child->parent;
+        count += node->subtree_count.load(std::memory_order_relaxed);
+    }
+    return count;
+}
+
+// 递归重算整棵子树的键数（批量构建和反序列化后调用）
+template <typename Key, int Order>
+int64_t BPlusTree<Key, Order>::recount(BaseNode<Key>* node) {
+    if (!node) return 0;
+    if (node->is_leaf) {
+        node->subtree_count = node->size;
+    } else {
+        int64_t count = 0;
+        for (auto child : static_cast<InternalNode<Key>*>(node)->children) count += recount(child);
+        node->subtree_count = count;
+    }
+    return node->subtree_count;
+}
+
+// 空树时创建根节点，对头叶子的CAS保证并发插入只有一个线程成功。
+// 头叶子先于根节点发布，根节点可见时头叶子一定可见，失败的线程等待根节点发布后再返回
+template <typename Key, int Order>
+void BPlusTree<Key, Order>::ensure_root() {
+    if (root.load()) return;
+    LeafNode<Key>* leaf = LeafNode<Key>::create(node_order());
+    LeafNode<Key>* expected = nullptr;
+    if (head_leaf.compare_exchange_strong(expected, leaf)) {
+        root.store(leaf);
+        return;
+    }
+    delete leaf;
+    while (!root.load()) std::this_thread::yield();
+}
+
+
+template <typename Key, int Order>
+uint64_t BPlusTree<Key, Order>::find(const Key& key) const {
+    std::shared_lock<OperationGate> lock(tree_gate);
+    EpochGuard guard(epoch_manager);
+
+    if constexpr (optimistic_read) {
+        // 乐观读：不写任何共享内存，读完后校验叶子版本号，冲突则重试
+        while (true) {
+            uint64_t version;
+            LeafNode<Key>* leaf = static_cast<LeafNode<Key>*>(find_node_optimistic(key, 0, version));
+            if (!leaf) return 0;
+
+            int index = leaf->find_index(key);
+            uint64_t result = 0;
+            if (index < leaf->size && leaf->keys.equals(index, key)) {
+                result = leaf->values[index];
+            }
+            if (leaf->validate(version)) return result;
+        }
+    }
 
     // 查找叶子节点并获取共享锁
     std::queue<BaseNode<Key>*> unique_locked_queue;  //加了写锁的祖先节点,无用
     LeafNode<Key>* leaf = find_leaf(key, unique_locked_queue, false);
+    if (!leaf) return 0;
 
     int index = leaf->find_index(key);
     uint64_t result = 0;
-    if (index < leaf->size && leaf->keys[index] == key) {
+    if (index < leaf->size && leaf->keys.equals(index, key)) {
         result = leaf->values[index];
     }
 
     // 释放锁
-    if (leaf == root) root_mutex.unlock_shared();
     leaf->mutex.unlock_shared();
 
     return result;
 }
 
-template <typename Key>
-void BPlusTree<Key>::remove(const Key& key) {
-    root_mutex.lock();
-    if (!root) return;
+// 预取节点头部和键数组开头的几个缓存行
+static inline void prefetch_node(const void* node) {
+#if defined(__GNUC__)
+    const char* bytes = static_cast<const char*>(node);
+    for (int offset = 0; offset < 256; offset += 64) {
+        __builtin_prefetch(bytes + offset);
+    }
+#endif
+}
+
+// 批量查找：一组键按层交替推进，每个键确定下一层节点后先发出预取，
+// 等组内其他键各走一步后再访问该节点，用多个键的访存重叠掩盖内存延迟。
+// 乐观读校验失败的键退回单键查找；字符串键不走乐观读，逐个查找
+template <typename Key, int Order>
+std::vector<uint64_t> BPlusTree<Key, Order>::find_batch(const std::vector<Key>& keys) const {
+    std::shared_lock<OperationGate> lock(tree_gate);
+    EpochGuard guard(epoch_manager);
+    std::vector<uint64_t> results(keys.size(), 0);
+
+    if constexpr (!optimistic_read) {
+        for (size_t i = 0; i < keys.size(); i++) {
+            results[i] = find(keys[i]);
+        }
+        return results;
+    } else {
+        struct Probe {
+            BaseNode<Key>* node;
+            uint64_t version;
+            BaseNode<Key>* next;  // 已预取、下一轮进入的节点
+            bool done;
+        };
+        const size_t group_size = 16;
+        Probe probes[group_size];
+
+        for (size_t base = 0; base < keys.size(); base += group_size) {
+            size_t count = std::min(group_size, keys.size() - base);
+            size_t active = count;
+
+            BaseNode<Key>* start = root.load(std::memory_order_acquire);
+            if (!start) return results;
+            uint64_t start_version = start->read_version();
+            bool start_valid = start == root.load(std::memory_order_acquire);
+            for (size_t j = 0; j < count; j++) {
+                probes[j] = {start, start_version, nullptr, false};
+                if (!start_valid) {
+                    results[base + j] = find(keys[base + j]);
+                    probes[j].done = true;
+                    active--;
+                }
+            }
+
+            while (active > 0) {
+                for (size_t j = 0; j < count; j++) {
+                    Probe& probe = probes[j];
+                    if (probe.done) continue;
+                    const Key& key = keys[base + j];
+                    bool valid = true;
+
+                    // 进入上一轮预取的节点
+                    if (probe.next) {
+                        uint64_t next_version = probe.next->read_version();
+                        valid = probe.node->validate(probe.version);
+                        probe.node = probe.next;
+                        probe.version = next_version;
+                        probe.next = nullptr;
+                    }
+
+                    BaseNode<Key>* node = probe.node;
+                    BaseNode<Key>* next = nullptr;
+                    if (valid && node->beyond_high_key(key)) {
+                        next = right_link(node);
+                    } else if (valid && node->is_leaf) {
+                        LeafNode<Key>* leaf = static_cast<LeafNode<Key>*>(node);
+                        int index = leaf->find_index(key);
+                        uint64_t result = 0;
+                        if (index < leaf->size && leaf->keys.equals(index, key)) {
+                            result = leaf->values[index];
+                        }
+                        if (leaf->validate(probe.version)) {
+                            results[base + j] = result;
+                            probe.done = true;
+                            active--;
+                            continue;
+                        }
+                        valid = false;
+                    } else if (valid) {
+                        InternalNode<Key>* inode = static_cast<InternalNode<Key>*>(node);
+                        int index = inode->find_index(key);
+                        if (index < inode->size && inode->keys.equals(index, key)) {
+                            index++;
+                        }
+                        next = inode->children[index];
+                    }
+
+                    if (!valid || !node->validate(probe.version)) {
+                        results[base + j] = find(key);
+                        probe.done = true;
+                        active--;
+                        continue;
+                    }
+                    prefetch_node(next);
+                    probe.next = next;
+                }
+            }
+        }
+        return results;
+    }
+}
+
+template <typename Key, int Order>
+void BPlusTree<Key, Order>::remove(const Key& key) {
+    std::shared_lock<OperationGate> lock(tree_gate);
+    EpochGuard guard(epoch_manager);
 
     // 查找叶子节点并获取锁
     std::queue<BaseNode<Key>*> unique_locked_queue;  //加了写锁的祖先节点
     LeafNode<Key>* leaf = find_leaf(key, unique_locked_queue, true);
+    if (!leaf) return;
 
     int index = leaf->find_index(key);
-    if (index >= leaf->size || leaf->keys[index] != key) {
-        // 键不存在，释放锁
-        // leaf->mutex.unlock();
-        BaseNode<Key>* parent;
-        while (!unique_locked_queue.empty()) {
-            parent = unique_locked_queue.front();  //从最上层开始释放
-            if (parent == root) root_mutex.unlock();
-            unique_locked_queue.pop();
-            parent->mutex.unlock();
+    uint64_t lsn = 0;
+    if (index < leaf->size && leaf->keys.equals(index, key)) {
+        // 先追加日志再删除，追加失败时释放所有写锁后上抛
+        try {
+            lsn = log_write(WAL_REMOVE, key, 0);
+        } catch (...) {
+            while (!unique_locked_queue.empty()) {
+                unique_locked_queue.front()->write_unlock();
+                unique_locked_queue.pop();
+            }
+            throw;
         }
-        return;
-    }
+        leaf->remove_from_node(index, node_order());
+        add_count(leaf, -1);
 
-    // 删除操作
-    leaf->remove_from_node(index, order);
-
-    // 处理下溢
-    handle_underflow(leaf);
+        // 处理下溢
+        handle_underflow(leaf);
+    }
 
     // 释放锁
-    // leaf->mutex.unlock();
     BaseNode<Key>* parent;
     while (!unique_locked_queue.empty()) {
         parent = unique_locked_queue.front();  //从最上层开始释放
-        if (parent == root) root_mutex.unlock();
         unique_locked_queue.pop();
-        parent->mutex.unlock();
+        parent->write_unlock();
     }
+    log_commit(lsn);
 }
 
 // 范围查找 [start, end]
-template <typename Key>
-std::vector<std::pair<Key, uint64_t>> BPlusTree<Key>::range_find(const Key& start, const Key& end) const {
-    std::shared_lock<std::shared_mutex> lock(tree_mutex);
+template <typename Key, int Order>
+std::vector<std::pair<Key, uint64_t>> BPlusTree<Key, Order>::range_find(const Key& start, const Key& end) const {
+    return range_collect(start, &end, RangeOptions());
+}
 
-    std::vector<std::pair<Key, uint64_t>> results;
+template <typename Key, int Order>
+std::vector<std::pair<Key, uint64_t>> BPlusTree<Key, Order>::range_find(const Key& start,
+                                                                       const RangeOptions& options) const {
+    return range_collect(start, nullptr, options);
+}
 
-    root_mutex.lock_shared();
-    if (!root) return results;
+template <typename Key, int Order>
+std::vector<std::pair<Key, uint64_t>> BPlusTree<Key, Order>::range_find(const Key& start, const Key& end,
+                                                                       const RangeOptions& options) const {
+    return range_collect(start, &end, options);
+}
 
-    // 查找起始叶子节点并获取共享锁
-    std::queue<BaseNode<Key>*> unique_locked_queue;  //加了写锁的祖先节点,无用
-    LeafNode<Key>* current = find_leaf(start, unique_locked_queue, false);
-    int start_index = 0;
-    if (current) start_index = current->find_index(start);
+// 从start所在叶子沿叶子链正向收集，超过end或达到limit时立即停止；end为nullptr表示无上界
+template <typename Key, int Order>
+std::vector<std::pair<Key, uint64_t>> BPlusTree<Key, Order>::range_collect(const Key& start, const Key* end,
+                                                                          const RangeOptions& options) const {
+    std::shared_lock<OperationGate> lock(tree_gate);
+    EpochGuard guard(epoch_manager);
+
+    std::vector<std::pair<Key, uint64_t>> results;
+    if (options.limit == 0) return results;
+    LeafNode<Key>* current = lock_leaf_shared(start);
+    if (!current) return results;
+    int start_index = current->find_index(start);
+    if (!options.start_inclusive && start_index < current->size && current->keys.equals(start_index, start)) {
+        start_index++;
+    }
 
     while (current) {
-        // 锁住当前叶子节点
-        // std::unique_lock<std::shared_mutex> current_lock(current->mutex);
         for (int i = start_index; i < current->size; i++) {
-            if (current->keys[i] >= start && current->keys[i] <= end) {
-                results.push_back({current->keys[i], current->values[i]});
-            } else if (current->keys[i] > end) {
+            const Key& key = current->keys[i];
+            bool past_end = end && (options.end_inclusive ? *end < key : !(key < *end));
+            if (past_end) {
                 // 释放当前锁并返回
-                if (current == root) root_mutex.unlock_shared();
+                current->mutex.unlock_shared();
+                return results;
+            }
+            results.push_back({key, current->values[i]});
+            if (results.size() >= options.limit) {
                 current->mutex.unlock_shared();
                 return results;
             }
         }
 
-        // 移动到下一个叶子节点
+        // 先锁住下一个叶子再释放当前叶子（从左到右加锁，与写者顺序一致），
+        // 避免下一个叶子在间隙中被并入当前叶子后沿已摘除节点走断链表
         LeafNode<Key>* next = current->next;
-
-        // 释放当前锁
-        if (current == root) root_mutex.unlock_shared();
+        if (next) next->mutex.lock_shared();
         current->mutex.unlock_shared();
-
-        if (next) {
-            // 锁住下一个节点
-            next->mutex.lock_shared();
-            start_index = 0;
-            current = next;
-        } else {
-            current = nullptr;
-        }
+        start_index = 0;
+        current = next;
     }
 
     return results;
 }
 
-// 序列化到文件（线程安全）
-template <typename Key>
-void BPlusTree<Key>::serialize(const std::string& base_filename) {
-    std::unique_lock<std::shared_mutex> lock(tree_mutex);
+template <typename Key, int Order>
+RangeCursor<Key, Order> BPlusTree<Key, Order>::scan(const Key& start) const {
+    return RangeCursor<Key, Order>(this, start, false);
+}
 
-    std::ofstream header_file(base_filename + ".header", std::ios::binary);
-    std::ofstream data_file(base_filename + ".data", std::ios::binary);
+template <typename Key, int Order>
+RangeCursor<Key, Order> BPlusTree<Key, Order>::scan_reverse(const Key& start) const {
+    return RangeCursor<Key, Order>(this, start, true);
+}
 
-    if (!header_file || !data_file) {
-        throw std::runtime_error("Failed to open files for serialization");
+template <typename Key, int Order>
+std::vector<std::pair<Key, uint64_t>> BPlusTree<Key, Order>::range_find_reverse(const Key& start, const Key& end,
+                                                                               size_t limit) const {
+    std::vector<std::pair<Key, uint64_t>> results;
+    for (auto cursor = scan_reverse(end); cursor.valid() && results.size() < limit; cursor.next()) {
+        if (cursor.key() < start) break;
+        results.push_back({cursor.key(), cursor.value()});
     }
+    return results;
+}
 
-    // 为每个节点分配唯一ID
-    std::unordered_map<BaseNode<Key>*, int32_t> node_ids;
-    int32_t next_id = 0;
+// 游标取下一批：复制from之后（inclusive时包含from）的条目，按整叶复制直到凑满
+// scan_batch_size或到达最后一个叶子，返回前释放所有锁
+template <typename Key, int Order>
+void BPlusTree<Key, Order>::scan_batch(const Key& from, bool inclusive,
+                                       std::vector<std::pair<Key, uint64_t>>& batch) const {
+    std::shared_lock<OperationGate> lock(tree_gate);
+    EpochGuard guard(epoch_manager);
+    batch.clear();
 
-    // 序列化元数据
-    int32_t key_type = 0;  // 0:int 1:string
-    int32_t root_id = -1;
-    int32_t head_leaf_id = -1;
+    LeafNode<Key>* current = lock_leaf_shared(from);
+    if (!current) return;
+    int index = current->find_index(from);
+    if (!inclusive && index < current->size && current->keys.equals(index, from)) index++;
 
-    if (std::is_same<Key, int>::value)
-        key_type = 0;
-    else if (std::is_same<Key, std::string>::value)
-        key_type = 1;
-    else
-        throw std::runtime_error("Failed to serialize：Unknown Key Type");
+    while (true) {
+        for (; index < current->size; index++) {
+            batch.push_back({current->keys[index], current->values[index]});
+        }
+        LeafNode<Key>* next = batch.size() < scan_batch_size ? current->next : nullptr;
+        if (next) next->mutex.lock_shared();
+        current->mutex.unlock_shared();
+        if (!next) return;
+        current = next;
+        index = 0;
+    }
+}
 
-    if (root) {
-        // 分配节点ID（使用BFS遍历）
-        std::queue<BaseNode<Key>*> q;
-        q.push(root);
-        node_ids[root] = next_id++;
+// 逆序取下一批：复制from之前（inclusive时包含from）的条目，按键递减。
+// 向左移动违背从左到右的加锁顺序，因此只对左邻叶子try_lock，并确认其next仍指向当前叶子；
+// 失败时释放当前叶子，以已扫描部分的下界重新自顶向下定位，任意时刻不会阻塞等待左侧的锁
+template <typename Key, int Order>
+void BPlusTree<Key, Order>::scan_batch_reverse(const Key& from, bool inclusive,
+                                               std::vector<std::pair<Key, uint64_t>>& batch) const {
+    std::shared_lock<OperationGate> lock(tree_gate);
+    EpochGuard guard(epoch_manager);
+    batch.clear();
+
+    LeafNode<Key>* current = lock_leaf_shared(from);
+    if (!current) return;
+    int index = current->find_index(from);
+    if (inclusive && index < current->size && current->keys.equals(index, from)) index++;
+
+    // bound：尚未扫描的键都小于bound；low_key：当前叶子的下界（已知时）
+    Key bound = from;
+    Key low_key = from;
+    bool has_low_key = false;
+    while (true) {
+        for (int i = index - 1; i >= 0; i--) {
+            batch.push_back({current->keys[i], current->values[i]});
+        }
+        if (has_low_key) {
+            bound = low_key;
+        } else if (current->size > 0) {
+            bound = current->keys[0];
+        }
 
-        if (head_leaf) {
-            node_ids[head_leaf] = next_id++;
+        LeafNode<Key>* prev = current->prev.load(std::memory_order_acquire);
+        if (batch.size() >= scan_batch_size || !prev) {
+            current->mutex.unlock_shared();
+            return;
+        }
+        if (prev->mutex.try_lock_shared()) {
+            if (prev->next == current) {
+                current->mutex.unlock_shared();
+                current = prev;
+                index = prev->size;
+                has_low_key = false;
+                continue;
+            }
+            prev->mutex.unlock_shared();
         }
 
-        while (!q.empty()) {
-            BaseNode<Key>* node = q.front();
-            q.pop();
+        current->mutex.unlock_shared();
+        current = lock_leaf_before(bound, low_key, has_low_key);
+        if (!current) return;
+        index = current->find_index(bound);
+    }
+}
 
-            if (!node->is_leaf) {
-                InternalNode<Key>* inode = static_cast<InternalNode<Key>*>(node);
-                for (auto child : inode->children) {
-                    if (node_ids.find(child) == node_ids.end()) {
-                        node_ids[child] = next_id++;
-                        q.push(child);
-                    }
+// 定位可能包含小于key的最大键的叶子并加共享锁（自顶向下、从左到右加锁），
+// 同时返回下降路径上得到的叶子下界
+template <typename Key, int Order>
+LeafNode<Key>* BPlusTree<Key, Order>::lock_leaf_before(const Key& key, Key& low_key, bool& has_low_key) const {
+    BaseNode<Key>* node = lock_root_shared();
+    if (!node) return nullptr;
+    has_low_key = false;
+
+    while (true) {
+        // 上界小于key时，小于key的键可能在右侧节点
+        while (node->has_high_key && node->high_key < key) {
+            BaseNode<Key>* right = right_link(node);
+            right->mutex.lock_shared();
+            low_key = node->high_key;
+            has_low_key = true;
+            node->mutex.unlock_shared();
+            node = right;
+        }
+        if (node->is_leaf) return static_cast<LeafNode<Key>*>(node);
+
+        // 子节点i包含[keys[i-1], keys[i])，选第一个分隔键不小于key的子节点
+        InternalNode<Key>* inode = static_cast<InternalNode<Key>*>(node);
+        int index = inode->find_index(key);
+        if (index > 0) {
+            low_key = inode->keys[index - 1];
+            has_low_key = true;
+        }
+        BaseNode<Key>* child = inode->children[index];
+        child->mutex.lock_shared();
+        node->mutex.unlock_shared();
+        node = child;
+    }
+}
+
+// 定位key所在叶子并加共享锁，树为空时返回nullptr
+template <typename Key, int Order>
+LeafNode<Key>* BPlusTree<Key, Order>::lock_leaf_shared(const Key& key) const {
+    if constexpr (optimistic_read) {
+        // 乐观下降到叶子，加共享锁后确认叶子在此期间未被修改
+        while (true) {
+            uint64_t version;
+            LeafNode<Key>* leaf = static_cast<LeafNode<Key>*>(find_node_optimistic(key, 0, version));
+            if (!leaf) return nullptr;
+            leaf->mutex.lock_shared();
+            if (leaf->validate(version)) return leaf;
+            leaf->mutex.unlock_shared();
+        }
+    } else {
+        std::queue<BaseNode<Key>*> unique_locked_queue;  //加了写锁的祖先节点,无用
+        return find_leaf(key, unique_locked_queue, false);
+    }
+}
+
+template <typename Key, int Order>
+void BPlusTree<Key, Order>::bulk_load(typename std::vector<std::pair<Key, uint64_t>>::const_iterator first,
+                                      typename std::vector<std::pair<Key, uint64_t>>::const_iterator last,
+                                      double fill_factor, int num_threads) {
+    std::unique_lock<OperationGate> lock(tree_gate);
+
+    long long total = last - first;
+    if (total == 0) {
+        clear_tree();
+        return;
+    }
+
+    // 叶子的目标大小按填充率取在半满到全满之间，各节点再均分输入，不会生成欠载节点
+    int min_leaf = (node_order() + 1) / 2;
+    int leaf_fill = std::max(min_leaf, std::min(node_order(), static_cast<int>(node_order() * fill_factor)));
+    int leaf_count = static_cast<int>(bulk_node_count(total, leaf_fill, min_leaf, node_order()));
+
+    // 叶子i包含输入中[leaf_begin(i), leaf_begin(i + 1))的元素，各叶子大小相差不超过1
+    auto leaf_begin = [&](int i) { return total * i / leaf_count; };
+
+    std::vector<BaseNode<Key>*> level(leaf_count, nullptr);
+    std::vector<Key> low_keys(leaf_count);
+    std::atomic<bool> unsorted(false);
+
+    auto build_leaves = [&](int begin, int end) {
+        for (int i = begin; i < end && !unsorted; i++) {
+            LeafNode<Key>* leaf = LeafNode<Key>::create(node_order());
+            level[i] = leaf;
+            for (long long j = leaf_begin(i); j < leaf_begin(i + 1); j++) {
+                if (j > 0 && !(first[j - 1].first < first[j].first)) {
+                    unsorted = true;
+                    break;
                 }
+                leaf->keys.push_back(first[j].first);
+                leaf->values.push_back(first[j].second);
             }
+            leaf->size = leaf->keys.size();
+            low_keys[i] = first[leaf_begin(i)].first;
+        }
+    };
+
+    num_threads = std::max(1, std::min(num_threads, leaf_count));
+    if (num_threads == 1) {
+        build_leaves(0, leaf_count);
+    } else {
+        std::vector<std::thread> threads;
+        for (int t = 0; t < num_threads; t++) {
+            threads.emplace_back(build_leaves, leaf_count * t / num_threads, leaf_count * (t + 1) / num_threads);
         }
+        for (auto& thread : threads) thread.join();
+    }
+
+    // 输入无序时丢弃已构建的叶子，树的当前内容保持不变
+    if (unsorted) {
+        for (auto node : level) delete node;
+        throw std::runtime_error("Bulk load input must be sorted by unique keys");
+    }
 
-        root_id = node_ids[root];
-        if (head_leaf) {
-            head_leaf_id = node_ids[head_leaf];
+    for (int i = 1; i < leaf_count; i++) {
+        static_cast<LeafNode<Key>*>(level[i])->prev.store(static_cast<LeafNode<Key>*>(level[i - 1]),
+                                                          std::memory_order_release);
+    }
+    LeafNode<Key>* first_leaf = static_cast<LeafNode<Key>*>(level[0]);
+
+    // 逐层向上构建内部节点，分隔键为右侧子树的最小键；子节点数同样限制在半满到全满之间
+    int min_fanout = (node_order() + 1) / 2 + 1;
+    int fanout = std::max(min_fanout, std::min(node_order() + 1, static_cast<int>((node_order() + 1) * fill_factor)));
+    while (level.size() > 1) {
+        int child_count = level.size();
+        int parent_count = static_cast<int>(bulk_node_count(child_count, fanout, min_fanout, node_order() + 1));
+        std::vector<BaseNode<Key>*> parents(parent_count);
+        std::vector<Key> parent_low_keys(parent_count);
+
+        for (int p = 0; p < parent_count; p++) {
+            int begin = static_cast<long long>(child_count) * p / parent_count;
+            int end = static_cast<long long>(child_count) * (p + 1) / parent_count;
+            InternalNode<Key>* inode = InternalNode<Key>::create(node_order());
+            for (int c = begin; c < end; c++) {
+                if (c > begin) inode->keys.push_back(low_keys[c]);
+                inode->children.push_back(level[c]);
+            }
+            inode->size = end - begin - 1;
+            parents[p] = inode;
+            parent_low_keys[p] = low_keys[begin];
         }
+
+        level.swap(parents);
+        low_keys.swap(parent_low_keys);
     }
 
-    // 写入头文件
-    header_file.write(reinterpret_cast<const char*>(&key_type), sizeof(key_type));
-    header_file.write(reinterpret_cast<const char*>(&order), sizeof(order));
-    header_file.write(reinterpret_cast<const char*>(&root_id), sizeof(root_id));
-    header_file.write(reinterpret_cast<const char*>(&head_leaf_id), sizeof(head_leaf_id));
+    // 新树构建完成后才替换当前树
+    clear_tree();
+    root = level[0];
+    head_leaf = first_leaf;
+    // 层号、父指针、上界和右链接统一按层设置
+    link_levels();
+    if (counted) recount(root);
+}
+
+// 清除当前树（调用方独占tree_gate），新内容不在日志中，下一次检查点须为全量
+template <typename Key, int Order>
+void BPlusTree<Key, Order>::clear_tree() {
+    checkpoint_full = true;
+    delete root.load();
+    root = nullptr;
+    head_leaf = nullptr;
+    epoch_manager.reclaim_all();
+}
+
+// 序列化到文件（线程安全）
+// 单次DFS完成ID分配与写出：子节点在父节点写出时按顺序分配ID，叶子的下一叶子ID
+// 在遍历到下一叶子时回填。记录先编码进大块缓冲，再以大块顺序写出
+template <typename Key, int Order>
+void BPlusTree<Key, Order>::serialize(const std::string& base_filename) {
+    std::unique_lock<OperationGate> lock(tree_gate);
+
+    // 序列化元数据
+    int32_t key_type = 0;  // 0:int 1:string
+    int32_t root_id = -1;
+    int32_t head_leaf_id = -1;
+
+    if (std::is_same<Key, int>::value)
+        key_type = 0;
+    else if (std::is_same<Key, std::string>::value)
+        key_type = 1;
+    else
+        throw std::runtime_error("Failed to serialize：Unknown Key Type");
+
+    BufferedFileWriter data_file(base_filename + ".data");
 
-    // 写入节点数据（使用DFS遍历）
+    // 写入节点数据（使用DFS遍历），同时记录每条记录在数据文件中的偏移
+    std::vector<uint64_t> record_offsets;
     if (root) {
-        std::stack<BaseNode<Key>*> s;
-        s.push(root);
+        int32_t next_id = 0;
+        std::stack<std::pair<BaseNode<Key>*, int32_t>> s;
+        root_id = next_id++;
+        s.push({root, root_id});
+
+        // 上一个叶子记录中下一叶子ID字段的位置
+        uint64_t pending_next = 0;
+        bool has_pending_next = false;
 
         while (!s.empty()) {
-            BaseNode<Key>* node = s.top();
+            auto [node, node_id] = s.top();
             s.pop();
 
-            int32_t node_id = node_ids[node];
+            record_offsets.push_back(data_file.position());
             char node_type = node->is_leaf ? 1 : 0;
 
             // 写入节点ID和类型
-            data_file.write(reinterpret_cast<const char*>(&node_id), sizeof(node_id));
-            data_file.write(&node_type, sizeof(node_type));
+            data_file.put(node_id);
+            data_file.put(node_type);
 
             // 写入节点大小
             int32_t size = node->size;
-            data_file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+            data_file.put(size);
 
             // 写入键
             for (int i = 0; i < size; i++) {
@@ -256,35 +1056,224 @@ void BPlusTree<Key>::serialize(const std::string& base_filename) {
                 LeafNode<Key>* leaf = static_cast<LeafNode<Key>*>(node);
 
                 // 写入值
-                for (int i = 0; i < size; i++) {
-                    data_file.write(reinterpret_cast<const char*>(&leaf->values[i]), sizeof(uint64_t));
-                }
+                data_file.write(&leaf->values[0], sizeof(uint64_t) * size);
 
-                // 写入下一个叶子节点ID
-                int32_t next_leaf_id = leaf->next ? node_ids[leaf->next] : -1;
-                data_file.write(reinterpret_cast<const char*>(&next_leaf_id), sizeof(next_leaf_id));
+                // DFS按键序访问叶子，回填上一个叶子的下一叶子ID
+                if (has_pending_next) {
+                    data_file.patch(pending_next, &node_id, sizeof(node_id));
+                } else {
+                    head_leaf_id = node_id;
+                }
+                pending_next = data_file.position();
+                has_pending_next = true;
+                data_file.put(int32_t(-1));
             } else {
                 InternalNode<Key>* inode = static_cast<InternalNode<Key>*>(node);
 
                 // 写入子节点ID
+                int32_t first_child = next_id;
                 for (int i = 0; i <= size; i++) {
-                    int32_t child_id = node_ids[inode->children[i]];
-                    data_file.write(reinterpret_cast<const char*>(&child_id), sizeof(child_id));
+                    data_file.put(next_id++);
                 }
 
                 // 将子节点逆序压入堆栈，确保正确的反序列化顺序
                 for (int i = size; i >= 0; i--) {
-                    s.push(inode->children[i]);
+                    s.push({inode->children[i], first_child + i});
                 }
             }
         }
     }
+    uint64_t data_size = data_file.position();
+    data_file.close();
+
+    // 写入头文件
+    BufferedFileWriter header_file(base_filename + ".header", 64);
+    header_file.put(key_type);
+    header_file.put(order);
+    header_file.put(root_id);
+    header_file.put(head_leaf_id);
+    header_file.close();
+
+    // 节点偏移索引：数据文件大小 + 记录数 + 按写出顺序的记录偏移，供并行反序列化分块
+    BufferedFileWriter index_file(base_filename + ".index");
+    int32_t record_count = static_cast<int32_t>(record_offsets.size());
+    index_file.put(data_size);
+    index_file.put(record_count);
+    index_file.write(record_offsets.data(), sizeof(uint64_t) * record_offsets.size());
+    index_file.close();
+}
+
+// 节点按层自底向上写出：叶子在前，其偏移在写出时即可确定下一叶子的位置；
+// 上一层按顺序写出时，子节点依次对应下一层的偏移，无需节点到ID的映射
+template <typename Key, int Order>
+void BPlusTree<Key, Order>::serialize_mapped(const std::string& path) {
+    std::unique_lock<OperationGate> lock(tree_gate);
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file) throw std::runtime_error("Failed to open file for serialization");
+
+    MappedSnapshotHeader header{};
+    header.magic = MAPPED_SNAPSHOT_MAGIC;
+    header.key_type = std::is_same<Key, int>::value ? 0 : 1;
+    header.order = node_order();
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));  // 占位，最后回填
+
+    // 自顶向下收集各层节点
+    std::vector<std::vector<BaseNode<Key>*>> levels;
+    if (root) levels.push_back({root.load()});
+    while (!levels.empty() && !levels.back().front()->is_leaf) {
+        std::vector<BaseNode<Key>*> next_level;
+        for (BaseNode<Key>* node : levels.back()) {
+            InternalNode<Key>* inode = static_cast<InternalNode<Key>*>(node);
+            for (int i = 0; i <= inode->size; i++) next_level.push_back(inode->children[i]);
+        }
+        levels.push_back(std::move(next_level));
+    }
+
+    uint64_t offset = sizeof(header);
+    std::vector<uint64_t> below;
+    std::string record;
+    for (auto level = levels.rbegin(); level != levels.rend(); ++level) {
+        std::vector<uint64_t> offsets;
+        offsets.reserve(level->size());
+        size_t child = 0;
+        for (size_t i = 0; i < level->size(); i++) {
+            BaseNode<Key>* node = (*level)[i];
+            encode_mapped_node(record, node, below, child);
+            if (node->is_leaf) {
+                header.entry_count += node->size;
+                uint64_t next = i + 1 < level->size() ? offset + record.size() : 0;
+                std::memcpy(&record[offsetof(MappedNodeHeader, next)], &next, sizeof(next));
+            }
+            offsets.push_back(offset);
+            file.write(record.data(), record.size());
+            offset += record.size();
+        }
+        if (level == levels.rbegin()) header.first_leaf = offsets.front();
+        below.swap(offsets);
+    }
+
+    header.root = below.empty() ? 0 : below.front();
+    header.file_size = offset;
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (!file) throw std::runtime_error("Failed to write snapshot");
+}
+
+// 沿叶子链按键序收集条目，每COMPRESSED_BLOCK_ENTRIES个编码为一块，块目录写在最后并回填到文件头
+template <typename Key, int Order>
+void BPlusTree<Key, Order>::serialize_compressed(const std::string& path, SnapshotCodec codec) {
+    if (!codec_available(codec)) throw std::runtime_error("Snapshot codec not available");
+    std::unique_lock<OperationGate> lock(tree_gate);
+
+    BufferedFileWriter file(path);
+    CompressedSnapshotHeader header{};
+    header.magic = COMPRESSED_SNAPSHOT_MAGIC;
+    header.key_type = std::is_same<Key, int>::value ? 0 : 1;
+    file.put(header);  // 占位，最后回填
+
+    std::vector<CompressedBlockEntry> directory;
+    std::vector<std::pair<Key, uint64_t>> entries;
+    entries.reserve(COMPRESSED_BLOCK_ENTRIES);
+    std::string raw, compressed;
+    auto write_block = [&] {
+        encode_block(raw, entries);
+        CompressedBlockEntry block{};
+        block.offset = file.position();
+        block.raw_size = static_cast<uint32_t>(raw.size());
+        block.entry_count = static_cast<uint32_t>(entries.size());
+        if (compress_block(codec, raw, compressed)) {
+            block.codec = static_cast<uint8_t>(codec);
+            block.stored_size = static_cast<uint32_t>(compressed.size());
+            file.write(compressed.data(), compressed.size());
+        } else {
+            block.codec = static_cast<uint8_t>(SnapshotCodec::none);
+            block.stored_size = block.raw_size;
+            file.write(raw.data(), raw.size());
+        }
+        directory.push_back(block);
+        header.entry_count += entries.size();
+        entries.clear();
+    };
+
+    for (LeafNode<Key>* leaf = head_leaf.load(); leaf; leaf = leaf->next) {
+        for (int i = 0; i < leaf->size; i++) {
+            entries.emplace_back(leaf->keys[i], leaf->values[i]);
+            if (entries.size() == COMPRESSED_BLOCK_ENTRIES) write_block();
+        }
+    }
+    if (!entries.empty()) write_block();
+
+    header.block_count = static_cast<uint32_t>(directory.size());
+    header.directory = file.position();
+    file.write(directory.data(), sizeof(CompressedBlockEntry) * directory.size());
+    file.patch(0, &header, sizeof(header));
+    file.close();
+}
+
+// 整个文件一次读入，各线程解压并解码一段连续的块，直接写入条目数组中该块的位置，再自底向上构建
+template <typename Key, int Order>
+void BPlusTree<Key, Order>::deserialize_compressed(const std::string& path, int num_threads) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) throw std::runtime_error("Failed to open files for deserialization");
+    std::string data(static_cast<size_t>(file.tellg()), '\0');
+    file.seekg(0);
+    if (!file.read(&data[0], data.size())) throw std::runtime_error("Failed to read compressed snapshot");
+
+    CompressedSnapshotHeader header;
+    if (data.size() < sizeof(header)) throw std::runtime_error("Corrupted compressed snapshot");
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (header.magic != COMPRESSED_SNAPSHOT_MAGIC) throw std::runtime_error("Corrupted compressed snapshot");
+    if (header.key_type != (std::is_same<Key, int>::value ? 0 : 1)) {
+        throw std::runtime_error("Failed to deserialize：Key Type Not Match");
+    }
+    if (header.directory < sizeof(header) || header.directory > data.size() ||
+        (data.size() - header.directory) / sizeof(CompressedBlockEntry) < header.block_count) {
+        throw std::runtime_error("Corrupted compressed snapshot");
+    }
+
+    // 各块在条目数组中的起始位置
+    std::vector<CompressedBlockEntry> directory(header.block_count);
+    std::memcpy(directory.data(), data.data() + header.directory, sizeof(CompressedBlockEntry) * directory.size());
+    std::vector<uint64_t> starts(directory.size());
+    uint64_t total = 0;
+    for (size_t i = 0; i < directory.size(); i++) {
+        const CompressedBlockEntry& block = directory[i];
+        if (block.entry_count > COMPRESSED_BLOCK_ENTRIES || block.offset < sizeof(header) ||
+            block.offset > header.directory || header.directory - block.offset < block.stored_size) {
+            throw std::runtime_error("Corrupted compressed snapshot");
+        }
+        starts[i] = total;
+        total += block.entry_count;
+    }
+    if (total != header.entry_count) throw std::runtime_error("Corrupted compressed snapshot");
+
+    std::vector<std::pair<Key, uint64_t>> items(total);
+    int32_t block_count = static_cast<int32_t>(directory.size());
+    int threads_used = std::max(1, std::min(num_threads, block_count));
+    run_parallel(threads_used, block_count, [&](int32_t begin, int32_t end) {
+        std::string raw;
+        for (int32_t i = begin; i < end; i++) {
+            const CompressedBlockEntry& block = directory[i];
+            const char* stored = data.data() + block.offset;
+            if (block.codec == static_cast<uint8_t>(SnapshotCodec::none)) {
+                if (block.stored_size != block.raw_size) throw std::runtime_error("Corrupted compressed snapshot");
+                decode_block(stored, block.stored_size, &items[starts[i]], block.entry_count);
+            } else {
+                decompress_block(static_cast<SnapshotCodec>(block.codec), stored, block.stored_size, block.raw_size,
+                                 raw);
+                decode_block(raw.data(), raw.size(), &items[starts[i]], block.entry_count);
+            }
+        }
+    });
+
+    bulk_load(items.begin(), items.end(), 1.0, num_threads);
 }
 
 // 从文件反序列化（线程安全）
-template <typename Key>
-void BPlusTree<Key>::deserialize(const std::string& base_filename) {
-    std::unique_lock<std::shared_mutex> lock(tree_mutex);
+template <typename Key, int Order>
+void BPlusTree<Key, Order>::deserialize(const std::string& base_filename, int num_threads) {
+    std::unique_lock<OperationGate> lock(tree_gate);
 
     std::ifstream header_file(base_filename + ".header", std::ios::binary);
     std::ifstream data_file(base_filename + ".data", std::ios::binary);
@@ -293,30 +1282,34 @@ void BPlusTree<Key>::deserialize(const std::string& base_filename) {
         throw std::runtime_error("Failed to open files for deserialization");
     }
 
-    // 清除当前树
-    delete root;
-    root = nullptr;
-    head_leaf = nullptr;
-
-    // 读取头文件
+    // 先读取并校验头文件，不匹配时树的当前内容保持不变
     int32_t file_order, root_id, head_leaf_id, key_type;
     header_file.read(reinterpret_cast<char*>(&key_type), sizeof(key_type));
     header_file.read(reinterpret_cast<char*>(&file_order), sizeof(file_order));
     header_file.read(reinterpret_cast<char*>(&root_id), sizeof(root_id));
     header_file.read(reinterpret_cast<char*>(&head_leaf_id), sizeof(head_leaf_id));
+    if (!header_file) {
+        throw std::runtime_error("Failed to deserialize：Header Truncated");
+    }
 
     if (!(std::is_same<Key, int>::value && key_type == 0 || std::is_same<Key, std::string>::value && key_type == 1)) {
         throw std::runtime_error("Failed to deserialize：Key Type Not Match");
     }
 
+    if (Order > 0 && file_order != Order) {
+        throw std::runtime_error("Failed to deserialize：Order Not Match");
+    }
+
+    clear_tree();
     order = file_order;
 
     // 如果没有根节点，直接返回
     if (root_id == -1) {
         return;
     }
+    if (deserialize_indexed(base_filename, root_id, head_leaf_id, num_threads)) return;
 
-    // 读取所有节点
+    // 没有索引的旧快照：逐条读取，通过ID映射建立链接
     std::unordered_map<int32_t, BaseNode<Key>*> id_to_node;
     std::unordered_map<int32_t, int32_t> leaf_next_ids;
     std::unordered_map<int32_t, std::vector<int32_t>> internal_children_ids;
@@ -332,11 +1325,15 @@ void BPlusTree<Key>::deserialize(const std::string& base_filename) {
 
         int32_t size;
         data_file.read(reinterpret_cast<char*>(&size), sizeof(size));
+        // 节点容量在创建时固定，拒绝超出容量的损坏数据
+        if (size < 0 || size > node_order() + 1) {
+            throw std::runtime_error("Failed to deserialize：Node Size Out Of Range");
+        }
 
         BaseNode<Key>* node = nullptr;
 
         if (node_type == 1) {  // 叶子节点
-            LeafNode<Key>* leaf = new LeafNode<Key>();
+            LeafNode<Key>* leaf = LeafNode<Key>::create(node_order());
             node = leaf;
             leaf->size = size;
 
@@ -358,7 +1355,7 @@ void BPlusTree<Key>::deserialize(const std::string& base_filename) {
             data_file.read(reinterpret_cast<char*>(&next_leaf_id), sizeof(next_leaf_id));
             leaf_next_ids[node_id] = next_leaf_id;
         } else {  // 内部节点
-            InternalNode<Key>* inode = new InternalNode<Key>();
+            InternalNode<Key>* inode = InternalNode<Key>::create(node_order());
             node = inode;
             inode->size = size;
 
@@ -392,7 +1389,7 @@ void BPlusTree<Key>::deserialize(const std::string& base_filename) {
             if (next_id != -1 && id_to_node.find(next_id) != id_to_node.end()) {
                 leaf->next = static_cast<LeafNode<Key>*>(id_to_node[next_id]);
                 if (leaf->next) {
-                    leaf->next->prev = leaf;
+                    leaf->next->prev.store(leaf, std::memory_order_release);
                 }
             }
         } else {
@@ -417,11 +1414,368 @@ void BPlusTree<Key>::deserialize(const std::string& base_filename) {
     if (head_leaf_id != -1 && id_to_node.find(head_leaf_id) != id_to_node.end()) {
         head_leaf = static_cast<LeafNode<Key>*>(id_to_node[head_leaf_id]);
     }
+
+    // 文件中不保存层号、上界和内部节点右链接，按层重建
+    link_levels();
+    if (counted) recount(root);
+}
+
+// 读取一条节点记录，叶子返回下一叶子ID，内部节点返回子节点ID
+template <typename Key, int Order>
+BaseNode<Key>* BPlusTree<Key, Order>::read_node(std::ifstream& file, int32_t& node_id, int32_t& next_leaf_id,
+                                                std::vector<int32_t>& children_ids) {
+    char node_type;
+    int32_t size;
+    file.read(reinterpret_cast<char*>(&node_id), sizeof(node_id));
+    file.read(&node_type, sizeof(node_type));
+    file.read(reinterpret_cast<char*>(&size), sizeof(size));
+    if (!file) throw std::runtime_error("Failed to deserialize：Truncated Node");
+    if (size < 0 || size > node_order() + 1) {
+        throw std::runtime_error("Failed to deserialize：Node Size Out Of Range");
+    }
+
+    if (node_type == 1) {
+        LeafNode<Key>* leaf = LeafNode<Key>::create(node_order());
+        leaf->size = size;
+        for (int i = 0; i < size; i++) leaf->keys.push_back(deserialize_key(file));
+        for (int i = 0; i < size; i++) {
+            uint64_t value;
+            file.read(reinterpret_cast<char*>(&value), sizeof(value));
+            leaf->values.push_back(value);
+        }
+        file.read(reinterpret_cast<char*>(&next_leaf_id), sizeof(next_leaf_id));
+        return leaf;
+    }
+
+    InternalNode<Key>* inode = InternalNode<Key>::create(node_order());
+    inode->size = size;
+    for (int i = 0; i < size; i++) inode->keys.push_back(deserialize_key(file));
+    children_ids.resize(size + 1);
+    file.read(reinterpret_cast<char*>(children_ids.data()), sizeof(int32_t) * (size + 1));
+    return inode;
+}
+
+// 按索引把记录均分给各线程，每个线程只定位一次然后顺序读取，节点放入按ID下标的数组；
+// 全部构建完成后再并行按ID建立子节点和叶子链接。没有可用索引时返回false
+template <typename Key, int Order>
+bool BPlusTree<Key, Order>::deserialize_indexed(const std::string& base_filename, int32_t root_id,
+                                                int32_t head_leaf_id, int num_threads) {
+    std::ifstream index_file(base_filename + ".index", std::ios::binary);
+    uint64_t data_size;
+    int32_t count;
+    if (!index_file.read(reinterpret_cast<char*>(&data_size), sizeof(data_size)) ||
+        !index_file.read(reinterpret_cast<char*>(&count), sizeof(count)) || count <= 0) {
+        return false;
+    }
+    std::vector<uint64_t> offsets(count);
+    index_file.read(reinterpret_cast<char*>(offsets.data()), sizeof(uint64_t) * count);
+    // 索引与数据文件不匹配（例如旧索引）时退回逐条读取
+    std::ifstream size_probe(base_filename + ".data", std::ios::binary | std::ios::ate);
+    if (!index_file || static_cast<uint64_t>(size_probe.tellg()) != data_size) return false;
+
+    std::vector<BaseNode<Key>*> nodes(count, nullptr);
+    std::vector<int32_t> next_ids(count, -1);
+    std::vector<std::vector<int32_t>> children_ids(count);
+    int threads_used = std::max(1, std::min(num_threads, count));
+
+    try {
+        // 第t块为写出顺序中的第[begin, end)条记录
+        run_parallel(threads_used, count, [&](int32_t begin, int32_t end) {
+            std::ifstream data_file(base_filename + ".data", std::ios::binary);
+            data_file.seekg(offsets[begin]);
+            for (int32_t i = begin; i < end; i++) {
+                int32_t node_id, next_id = -1;
+                std::vector<int32_t> child_ids;
+                BaseNode<Key>* node = read_node(data_file, node_id, next_id, child_ids);
+                if (node_id < 0 || node_id >= count || nodes[node_id]) {
+                    delete_node(node);
+                    throw std::runtime_error("Failed to deserialize：Invalid Node Id");
+                }
+                nodes[node_id] = node;
+                next_ids[node_id] = next_id;
+                children_ids[node_id] = std::move(child_ids);
+            }
+        });
+
+        // 第t块为ID在[begin, end)内的节点；每个叶子只被其前驱写prev，各线程写入的字段互不重叠
+        run_parallel(threads_used, count, [&](int32_t begin, int32_t end) {
+            for (int32_t id = begin; id < end; id++) {
+                BaseNode<Key>* node = nodes[id];
+                if (node->is_leaf) {
+                    int32_t next_id = next_ids[id];
+                    if (next_id < 0) continue;
+                    if (next_id >= count || !nodes[next_id]->is_leaf) {
+                        throw std::runtime_error("Failed to deserialize：Invalid Node Id");
+                    }
+                    LeafNode<Key>* leaf = static_cast<LeafNode<Key>*>(node);
+                    leaf->next = static_cast<LeafNode<Key>*>(nodes[next_id]);
+                    leaf->next->prev.store(leaf, std::memory_order_release);
+                } else {
+                    InternalNode<Key>* inode = static_cast<InternalNode<Key>*>(node);
+                    for (int32_t child_id : children_ids[id]) {
+                        if (child_id < 0 || child_id >= count) {
+                            throw std::runtime_error("Failed to deserialize：Invalid Node Id");
+                        }
+                        inode->children.push_back(nodes[child_id]);
+                        nodes[child_id]->parent = inode;
+                    }
+                }
+            }
+        });
+        if (root_id < 0 || root_id >= count || head_leaf_id >= count) {
+            throw std::runtime_error("Failed to deserialize：Invalid Node Id");
+        }
+    } catch (...) {
+        // 节点尚未可靠地连成树，逐个释放
+        for (BaseNode<Key>* node : nodes) {
+            if (!node) continue;
+            if (!node->is_leaf) static_cast<InternalNode<Key>*>(node)->children.clear();
+            delete_node(node);
+        }
+        throw;
+    }
+
+    root = nodes[root_id];
+    head_leaf = head_leaf_id >= 0 ? static_cast<LeafNode<Key>*>(nodes[head_leaf_id]) : nullptr;
+    link_levels();
+    if (counted) recount(root);
+    return true;
+}
+
+template <typename Key, int Order>
+void BPlusTree<Key, Order>::open(const std::string& base_filename, const WalOptions& options) {
+    if (wal) throw std::runtime_error("Tree is already opened");
+    wal_base = base_filename;
+
+    // 全量检查点之上依次叠加其后连续的增量检查点
+    std::vector<std::pair<Key, uint64_t>> items;
+    uint64_t first_segment = 0;
+    if (std::ifstream(checkpoint_path(0), std::ios::binary)) {
+        first_segment = read_checkpoint(checkpoint_path(0), items);
+    }
+    uint64_t delta_segment = first_segment;
+    while (std::ifstream(checkpoint_path(delta_segment + 1), std::ios::binary)) {
+        delta_segment++;
+        read_checkpoint(checkpoint_path(delta_segment), items);
+        checkpoint_deltas.push_back(delta_segment);
+    }
+    bulk_load(items.begin(), items.end());
+
+    // 从最后一个检查点对应的段开始依次重放，重放时尚未启用日志，记录不会被重复写入
+    uint64_t segment = delta_segment;
+    while (std::ifstream(wal_segment_path(segment), std::ios::binary)) {
+        WriteAheadLog::replay(wal_segment_path(segment),
+                              [this](const char* data, size_t size) { apply_log_record(data, size); });
+        segment++;
+    }
+
+    // 继续追加到最后一个段
+    std::unique_lock<OperationGate> lock(tree_gate);
+    wal_first_segment = first_segment;
+    wal_segment = segment > delta_segment ? segment - 1 : delta_segment;
+    max_checkpoint_deltas = options.max_checkpoint_deltas;
+    checkpoint_full = true;  // 重建后所有叶子都是脏的
+    wal = std::make_unique<WriteAheadLog>(wal_segment_path(wal_segment), options);
+}
+
+// 模糊检查点，读写操作不停顿：
+// 1. 日志切换到新段，此前的记录对应的修改都已写入叶子并置了脏标记（追加日志与修改在同一叶子锁内）；
+// 2. 沿叶子链写出叶子区间（增量检查点只写脏叶子），写出期间的并发修改可能被看到也可能没有；
+// 3. 恢复时加载检查点并从新段开始重放，插入和删除按键重放，结果与原顺序执行一致。
+// 增量检查点累计达到max_checkpoint_deltas个时改写全量检查点，之前的增量随之删除
+template <typename Key, int Order>
+void BPlusTree<Key, Order>::checkpoint() {
+    std::lock_guard<std::mutex> checkpoint_lock(checkpoint_mutex);
+    if (!wal) throw std::runtime_error("Checkpoint requires an opened tree");
+
+    uint64_t segment = wal_segment + 1;
+    wal->rotate(wal_segment_path(segment));
+    wal_segment = segment;
+
+    bool full;
+    std::string path;
+    try {
+        // bulk_load与deserialize独占tree_gate，在此期间不会替换树的内容
+        std::shared_lock<OperationGate> lock(tree_gate);
+        full = checkpoint_full.exchange(false) || checkpoint_deltas.size() >= max_checkpoint_deltas;
+        path = checkpoint_path(full ? 0 : segment);
+        write_checkpoint(path + ".tmp", segment, !full);
+        lock.unlock();
+
+        WriteAheadLog::sync_file(path + ".tmp");
+        if (std::rename((path + ".tmp").c_str(), path.c_str()) != 0) {
+            throw std::runtime_error("Failed to install checkpoint");
+        }
+        // 改名持久化之后才能删除被覆盖的文件，否则崩溃后可能既没有新检查点也没有旧日志
+        WriteAheadLog::sync_directory(path);
+    } catch (...) {
+        // 脏标记可能已被部分清除，下次改写全量
+        checkpoint_full = true;
+        throw;
+    }
+
+    if (full) {
+        for (uint64_t delta : checkpoint_deltas) std::remove(checkpoint_path(delta).c_str());
+        checkpoint_deltas.clear();
+    } else {
+        checkpoint_deltas.push_back(segment);
+    }
+    // 之前的日志段已被检查点覆盖
+    for (; wal_first_segment < segment; wal_first_segment++) std::remove(wal_segment_path(wal_first_segment).c_str());
+}
+
+// 检查点文件：键类型 + 重放起始段 + 按键递增的叶子区间记录。
+// 区间记录：标志（bit0有下界，bit1有上界）+ 下界 + 上界 + 条目数 + 条目；
+// 全量检查点包含所有叶子，区间首尾相接覆盖整个键空间。调用方持有tree_gate共享锁
+template <typename Key, int Order>
+void BPlusTree<Key, Order>::write_checkpoint(const std::string& path, uint64_t segment, bool only_dirty) {
+    BufferedFileWriter file(path);
+    int32_t key_type = std::is_same<Key, int>::value ? 0 : 1;
+    file.put(key_type);
+    file.put(segment);
+
+    EpochGuard guard(epoch_manager);
+    Key lowest{};
+    if constexpr (std::is_same<Key, int>::value) lowest = std::numeric_limits<int>::min();
+    LeafNode<Key>* current = lock_leaf_shared(lowest);
+
+    // 下界即前一个叶子的上界，沿叶子链加锁耦合，区间不会在两次读取之间改变
+    bool has_low_key = false;
+    Key low_key{};
+    while (current) {
+        if (!only_dirty || current->dirty) {
+            char flags = (has_low_key ? 1 : 0) | (current->has_high_key ? 2 : 0);
+            file.put(flags);
+            if (has_low_key) serialize_key(file, low_key);
+            if (current->has_high_key) serialize_key(file, current->high_key);
+            int32_t size = current->size;
+            file.put(size);
+            for (int i = 0; i < size; i++) {
+                serialize_key(file, current->keys[i]);
+                file.put(current->values[i]);
+            }
+            current->dirty = false;
+        }
+        has_low_key = current->has_high_key;
+        if (has_low_key) low_key = current->high_key;
+
+        LeafNode<Key>* next = current->next;
+        if (next) next->mutex.lock_shared();
+        current->mutex.unlock_shared();
+        current = next;
+    }
+    file.close();
+}
+
+// 读取检查点，用其中每个区间的条目替换items中同一区间的内容，返回重放日志的起始段
+template <typename Key, int Order>
+uint64_t BPlusTree<Key, Order>::read_checkpoint(const std::string& path, std::vector<std::pair<Key, uint64_t>>& items) {
+    std::ifstream file(path, std::ios::binary);
+    int32_t key_type;
+    uint64_t segment;
+    file.read(reinterpret_cast<char*>(&key_type), sizeof(key_type));
+    file.read(reinterpret_cast<char*>(&segment), sizeof(segment));
+    if (!file) throw std::runtime_error("Failed to read checkpoint");
+    if (key_type != (std::is_same<Key, int>::value ? 0 : 1)) {
+        throw std::runtime_error("Failed to read checkpoint：Key Type Not Match");
+    }
+
+    // 区间按键递增且互不重叠，与items做一次归并
+    std::vector<std::pair<Key, uint64_t>> merged;
+    merged.reserve(items.size());
+    size_t i = 0;
+    while (file.peek() != std::ifstream::traits_type::eof()) {
+        char flags;
+        file.read(&flags, 1);
+        Key low_key{}, high_key{};
+        if (flags & 1) low_key = deserialize_key(file);
+        if (flags & 2) high_key = deserialize_key(file);
+        int32_t size;
+        file.read(reinterpret_cast<char*>(&size), sizeof(size));
+        if (!file || size < 0) throw std::runtime_error("Failed to read checkpoint：Truncated Range");
+
+        for (; i < items.size() && (flags & 1) && items[i].first < low_key; i++) merged.push_back(std::move(items[i]));
+        while (i < items.size() && (!(flags & 2) || items[i].first < high_key)) i++;
+        for (int32_t k = 0; k < size; k++) {
+            Key key = deserialize_key(file);
+            uint64_t value;
+            file.read(reinterpret_cast<char*>(&value), sizeof(value));
+            merged.emplace_back(std::move(key), value);
+        }
+        if (!file) throw std::runtime_error("Failed to read checkpoint：Truncated Range");
+    }
+    for (; i < items.size(); i++) merged.push_back(std::move(items[i]));
+    items.swap(merged);
+    return segment;
+}
+
+// 全量检查点为base.ckpt，增量检查点以其重放起始段编号
+template <typename Key, int Order>
+std::string BPlusTree<Key, Order>::checkpoint_path(uint64_t delta_segment) const {
+    return delta_segment == 0 ? wal_base + ".ckpt" : wal_base + ".ckpt." + std::to_string(delta_segment);
+}
+
+template <typename Key, int Order>
+std::string BPlusTree<Key, Order>::wal_segment_path(uint64_t segment) const {
+    return wal_base + ".wal." + std::to_string(segment);
+}
+
+// 记录格式：类型(1字节) + 键（与serialize_key相同） + 值（仅插入，8字节）
+template <typename Key, int Order>
+uint64_t BPlusTree<Key, Order>::log_write(char op, const Key& key, uint64_t value) {
+    if (!wal) return 0;
+
+    std::string record(1, op);
+    if constexpr (std::is_same<Key, int>::value) {
+        record.append(reinterpret_cast<const char*>(&key), sizeof(key));
+    } else {
+        int32_t length = static_cast<int32_t>(key.size());
+        record.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        record.append(key);
+    }
+    if (op == WAL_INSERT) record.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    return wal->append(record.data(), record.size());
+}
+
+template <typename Key, int Order>
+void BPlusTree<Key, Order>::log_commit(uint64_t lsn) {
+    if (wal && lsn > 0) wal->wait_durable(lsn);
+}
+
+template <typename Key, int Order>
+void BPlusTree<Key, Order>::apply_log_record(const char* data, size_t size) {
+    const char* end = data + size;
+    char op = *data++;
+    Key key;
+    if constexpr (std::is_same<Key, int>::value) {
+        if (end - data < static_cast<long>(sizeof(key))) throw std::runtime_error("Corrupted log record");
+        std::memcpy(&key, data, sizeof(key));
+        data += sizeof(key);
+    } else {
+        int32_t length;
+        if (end - data < static_cast<long>(sizeof(length))) throw std::runtime_error("Corrupted log record");
+        std::memcpy(&length, data, sizeof(length));
+        data += sizeof(length);
+        if (length < 0 || end - data < length) throw std::runtime_error("Corrupted log record");
+        key.assign(data, length);
+        data += length;
+    }
+
+    if (op == WAL_INSERT) {
+        uint64_t value;
+        if (end - data != static_cast<long>(sizeof(value))) throw std::runtime_error("Corrupted log record");
+        std::memcpy(&value, data, sizeof(value));
+        insert(key, value);
+    } else if (op == WAL_REMOVE) {
+        remove(key);
+    } else {
+        throw std::runtime_error("Corrupted log record");
+    }
 }
 
 // 打印树结构（用于调试）
-template <typename Key>
-void BPlusTree<Key>::print_tree() const {
+template <typename Key, int Order>
+void BPlusTree<Key, Order>::print_tree() const {
     if (!root) return;
 
     std::queue<BaseNode<Key>*> q;
@@ -450,52 +1804,53 @@ void BPlusTree<Key>::print_tree() const {
     std::cout << std::endl;
 }
 
-// 递归查找叶子节点（带锁）
-template <typename Key>
-LeafNode<Key>* BPlusTree<Key>::find_leaf(const Key& key, std::queue<BaseNode<Key>*>& unique_locked_parent,
+// 自顶向下加锁查找叶子节点：for_write时加写锁并保留不安全的祖先节点，否则共享锁逐层交接
+template <typename Key, int Order>
+LeafNode<Key>* BPlusTree<Key, Order>::find_leaf(const Key& key, std::queue<BaseNode<Key>*>& unique_locked_parent,
                                          bool for_write) const {
+    if (!for_write) return static_cast<LeafNode<Key>*>(find_node_shared(key, 0));
+
     BaseNode<Key>* node = nullptr;
     BaseNode<Key>* parent = nullptr;
 
-    if (!root) return nullptr;
-    node = root;
-
-    // 锁住当前节点
-    if (for_write) {
-        node->mutex.lock();
-        unique_locked_parent.push(node);
-    } else {
-        node->mutex.lock_shared();
+    // 锁住根节点，等锁期间根节点可能已被替换
+    while (true) {
+        node = root.load();
+        if (!node) return nullptr;
+        node->write_lock();
+        if (node == root.load()) break;
+        node->write_unlock();
     }
+    unique_locked_parent.push(node);
 
     while (!node->is_leaf) {
         InternalNode<Key>* inode = static_cast<InternalNode<Key>*>(node);
         int index = inode->find_index(key);
-        if (index < inode->size && inode->keys[index] == key) {
+        if (index < inode->size && inode->keys.equals(index, key)) {
             index++;
         }
 
         BaseNode<Key>* child = inode->children[index];
 
         // 锁住子节点
-        if (for_write) {
-            child->mutex.lock();
-            // 检查子节点是否安全，安全则释放祖先锁,从最上层的祖先节点开始释放,稍微提升并发性能
-            if (for_write && child->is_safe(order)) {
-                while (!unique_locked_parent.empty()) {
-                    parent = unique_locked_parent.front();
-                    if (parent == root) root_mutex.unlock();
-                    unique_locked_parent.pop();
-                    parent->mutex.unlock();
-                }
+        child->write_lock();
+        // 子节点分裂后分隔键尚未安装到父节点，目标键可能已在右兄弟中
+        while (child->beyond_high_key(key)) {
+            BaseNode<Key>* right = right_link(child);
+            right->write_lock();
+            child->write_unlock();
+            child = right;
+        }
+
+        // 检查子节点是否安全，安全则释放祖先锁,从最上层的祖先节点开始释放,稍微提升并发性能
+        if (child->is_safe(node_order())) {
+            while (!unique_locked_parent.empty()) {
+                parent = unique_locked_parent.front();
+                unique_locked_parent.pop();
+                parent->write_unlock();
             }
-            unique_locked_parent.push(child);
-        } else {
-            child->mutex.lock_shared();
-            parent = node;
-            if (parent == root) root_mutex.unlock_shared();
-            parent->mutex.unlock_shared();
         }
+        unique_locked_parent.push(child);
 
         // 移动到子节点
         node = child;
@@ -504,56 +1859,256 @@ LeafNode<Key>* BPlusTree<Key>::find_leaf(const Key& key, std::queue<BaseNode<Key
     return static_cast<LeafNode<Key>*>(node);
 }
 
-// 插入后处理分裂
-template <typename Key>
-void BPlusTree<Key>::handle_split(BaseNode<Key>* node) {
-    if (!node || !node->is_overloaded(order)) return;
+// 对根节点加共享锁，加锁期间根节点被替换时重试；树为空时返回nullptr
+template <typename Key, int Order>
+BaseNode<Key>* BPlusTree<Key, Order>::lock_root_shared() const {
+    while (true) {
+        BaseNode<Key>* node = root.load();
+        if (!node) return nullptr;
+        node->mutex.lock_shared();
+        if (node == root.load()) return node;
+        node->mutex.unlock_shared();
+    }
+}
 
-    // 分裂节点
-    BaseNode<Key>* new_node = nullptr;
-    Key split_key;
-    if (node->is_leaf) {
-        LeafNode<Key>* leaf = static_cast<LeafNode<Key>*>(node);
-        LeafNode<Key>* new_leaf = leaf->split(order);
-        new_node = new_leaf;
-        split_key = new_leaf->keys[0];
-    } else {
-        InternalNode<Key>* internal = static_cast<InternalNode<Key>*>(node);
-        InternalNode<Key>* new_internal = internal->split(order);
-        new_node = new_internal;
-        split_key = internal->keys[internal->size];  // 分裂前中间键
+// 共享锁逐层交接查找level层覆盖key的节点，返回时持有该节点的共享锁
+template <typename Key, int Order>
+BaseNode<Key>* BPlusTree<Key, Order>::find_node_shared(const Key& key, int level) const {
+    BaseNode<Key>* node = lock_root_shared();
+    if (!node) return nullptr;
+    if (node->level < level) {
+        node->mutex.unlock_shared();
+        return nullptr;
     }
 
-    // 处理根节点分裂
-    if (node == root) {
-        InternalNode<Key>* new_root = new InternalNode<Key>();
-        new_root->keys.push_back(split_key);
-        new_root->children.push_back(node);
-        new_root->children.push_back(new_node);
-        new_root->size = 1;
+    while (true) {
+        // 沿右链接右移（从左到右加锁，与写者顺序一致）
+        while (node->beyond_high_key(key)) {
+            BaseNode<Key>* right = right_link(node);
+            right->mutex.lock_shared();
+            node->mutex.unlock_shared();
+            node = right;
+        }
+        if (node->level == level) return node;
+
+        InternalNode<Key>* inode = static_cast<InternalNode<Key>*>(node);
+        int index = inode->find_index(key);
+        if (index < inode->size && inode->keys.equals(index, key)) {
+            index++;
+        }
 
-        // 更新根节点
-        root = new_root;
-        node->parent = root;
-        new_node->parent = root;
-        root_mutex.unlock();
-        return;
+        BaseNode<Key>* child = inode->children[index];
+        child->mutex.lock_shared();
+        node->mutex.unlock_shared();
+        node = child;
+    }
+}
+
+// 乐观查找level层覆盖key的节点（不加锁），返回时node_version为该节点的版本号，调用方读取后需校验
+template <typename Key, int Order>
+BaseNode<Key>* BPlusTree<Key, Order>::find_node_optimistic(const Key& key, int level, uint64_t& node_version) const {
+    while (true) {
+        BaseNode<Key>* node = root.load(std::memory_order_acquire);
+        if (!node) return nullptr;
+
+        uint64_t version = node->read_version();
+        if (node != root.load(std::memory_order_acquire)) continue;  // 根节点已被替换
+        if (node->level < level) return nullptr;
+
+        bool restart = false;
+        while (true) {
+            BaseNode<Key>* next = nullptr;
+            if (node->beyond_high_key(key)) {
+                // 节点已分裂，沿右链接右移
+                next = right_link(node);
+            } else if (node->level == level) {
+                break;
+            } else {
+                InternalNode<Key>* inode = static_cast<InternalNode<Key>*>(node);
+                int index = inode->find_index(key);
+                if (index < inode->size && inode->keys.equals(index, key)) {
+                    index++;
+                }
+                next = inode->children[index];
+            }
+
+            // 先确认读到的指针有效，再读取下一个节点的版本号
+            if (!node->validate(version)) {
+                restart = true;
+                break;
+            }
+            uint64_t next_version = next->read_version();
+            if (!node->validate(version)) {
+                restart = true;
+                break;
+            }
+
+            node = next;
+            version = next_version;
+        }
+        if (restart) continue;
+
+        node_version = version;
+        return node;
     }
+}
 
+// 对level层覆盖key的节点加写锁：先无锁（或共享锁）定位，再加写锁并确认定位后节点未被修改
+template <typename Key, int Order>
+BaseNode<Key>* BPlusTree<Key, Order>::lock_node(const Key& key, int level) {
+    while (true) {
+        BaseNode<Key>* node = nullptr;
+        uint64_t version = 0;
+        if constexpr (optimistic_read) {
+            node = find_node_optimistic(key, level, version);
+        } else {
+            node = find_node_shared(key, level);
+            if (node) {
+                version = node->version.load();
+                node->mutex.unlock_shared();
+            }
+        }
+        if (!node) {
+            // 目标层尚不存在：等待并发的根节点调整完成
+            std::this_thread::yield();
+            continue;
+        }
 
-    // 将新节点插入父节点
-    InternalNode<Key>* parent = static_cast<InternalNode<Key>*>(node->parent);
-    int index = parent->find_index(split_key);
-    parent->insert_in_node(split_key, 0, new_node, order);
-    handle_split(parent);  // 递归检查父节点
+        node->write_lock();
+        if (node->version.load(std::memory_order_relaxed) == version + 1) return node;
+        node->write_unlock();
+    }
 }
 
-// 删除后处理下溢
-template <typename Key>
-void BPlusTree<Key>::handle_underflow(BaseNode<Key>* node) {
-    if (!node || node == root || !node->is_underloaded(order)) return;
+// B-link右链接：叶子节点即next指针
+template <typename Key, int Order>
+BaseNode<Key>* BPlusTree<Key, Order>::right_link(BaseNode<Key>* node) {
+    if (node->is_leaf) return static_cast<LeafNode<Key>*>(node)->next;
+    return static_cast<InternalNode<Key>*>(node)->right;
+}
+
+// 按层遍历，为整棵树重建层号、上界和右链接（反序列化等整体构建后调用）
+template <typename Key, int Order>
+void BPlusTree<Key, Order>::link_levels() {
+    if (!root) return;
+
+    int height = 0;
+    for (BaseNode<Key>* node = root; !node->is_leaf; node = static_cast<InternalNode<Key>*>(node)->children[0]) {
+        height++;
+    }
+
+    std::vector<BaseNode<Key>*> current_level{root.load()};
+    root.load()->level = height;
+    root.load()->has_high_key = false;
+    while (!current_level.front()->is_leaf) {
+        std::vector<BaseNode<Key>*> next_level;
+        for (auto node : current_level) {
+            InternalNode<Key>* inode = static_cast<InternalNode<Key>*>(node);
+            for (int i = 0; i <= inode->size; i++) {
+                BaseNode<Key>* child = inode->children[i];
+                child->level = inode->level - 1;
+                child->parent = inode;
+                // 子节点的上界是其右侧的分隔键，最右子节点继承父节点的上界
+                if (i < inode->size) {
+                    child->high_key = inode->keys[i];
+                    child->has_high_key = true;
+                } else {
+                    child->high_key = inode->high_key;
+                    child->has_high_key = inode->has_high_key;
+                }
+                next_level.push_back(child);
+            }
+        }
+        for (size_t i = 0; i < next_level.size(); i++) {
+            BaseNode<Key>* right = i + 1 < next_level.size() ? next_level[i + 1] : nullptr;
+            if (next_level[i]->is_leaf) {
+                static_cast<LeafNode<Key>*>(next_level[i])->next = static_cast<LeafNode<Key>*>(right);
+            } else {
+                static_cast<InternalNode<Key>*>(next_level[i])->right = static_cast<InternalNode<Key>*>(right);
+            }
+        }
+        current_level.swap(next_level);
+    }
+}
+
+// 插入后处理分裂（B-link）：node已加写锁且过载。新节点先通过右链接发布，
+// 释放node后再到上一层安装分隔键，任意时刻最多持有一个节点的写锁。
+// 计数模式下分裂和安装各自在count_mutex独占锁内完成，等待节点锁时不持有它
+template <typename Key, int Order>
+void BPlusTree<Key, Order>::handle_split(BaseNode<Key>* node) {
+    while (true) {
+        std::unique_lock<std::shared_mutex> count_lock(count_mutex, std::defer_lock);
+        begin_count_change(count_lock);
+
+        // 分裂节点
+        BaseNode<Key>* new_node = nullptr;
+        if (node->is_leaf) {
+            new_node = static_cast<LeafNode<Key>*>(node)->split(node_order());
+        } else {
+            new_node = static_cast<InternalNode<Key>*>(node)->split(node_order());
+        }
+        Key split_key = node->high_key;  // 分裂后左节点的上界即分隔键
+
+        if (counted) {
+            // 新节点安装前其键数仍计在原父节点中；移走的子节点连同其后未安装的分裂节点一起转移键数
+            new_node->parent = node->parent;
+            int64_t moved = 0;
+            if (node->is_leaf) {
+                moved = new_node->size;
+            } else {
+                for (auto child : static_cast<InternalNode<Key>*>(new_node)->children) {
+                    moved += adopt_split_chain(child, node);
+                }
+            }
+            node->subtree_count -= moved;
+            new_node->subtree_count = moved;
+        }
+
+        // 处理根节点分裂（持有旧根写锁，根节点不会被其他线程替换）
+        if (node == root) {
+            InternalNode<Key>* new_root = InternalNode<Key>::create(node_order());
+            new_root->level = node->level + 1;
+            new_root->keys.push_back(split_key);
+            new_root->children.push_back(node);
+            new_root->children.push_back(new_node);
+            new_root->size = 1;
+            new_root->subtree_count = node->subtree_count + new_node->subtree_count;
+
+            // 更新根节点
+            node->parent = new_root;
+            new_node->parent = new_root;
+            root.store(new_root, std::memory_order_release);
+            end_count_change(count_lock);
+            node->write_unlock();
+            return;
+        }
+        end_count_change(count_lock);
+
+        // 将新节点插入父节点
+        int parent_level = node->level + 1;
+        node->write_unlock();
+
+        BaseNode<Key>* parent = lock_node(split_key, parent_level);
+        begin_count_change(count_lock);
+        parent->insert_in_node(split_key, 0, new_node, node_order());
+        end_count_change(count_lock);
+        if (!parent->is_overloaded(node_order())) {
+            parent->write_unlock();
+            return;
+        }
+        node = parent;  // 继续检查父节点
+    }
+}
 
+// 删除后处理下溢：node及其不安全的祖先节点已加写锁
+template <typename Key, int Order>
+void BPlusTree<Key, Order>::handle_underflow(BaseNode<Key>* node) {
+    if (!node || node == root || !node->is_underloaded(node_order())) return;
+
+    // 分裂出的节点尚未安装到父节点（父指针为空，或计数模式下不在父节点的子节点中），暂不调整
     InternalNode<Key>* parent = static_cast<InternalNode<Key>*>(node->parent);
+    if (!parent) return;
+
     int child_index = -1;
     for (int i = 0; i < parent->children.size(); i++) {
         if (parent->children[i] == node) {
@@ -563,83 +2118,126 @@ void BPlusTree<Key>::handle_underflow(BaseNode<Key>* node) {
     }
     if (child_index == -1) return;
 
-    // 尝试从左兄弟借用
+    // 兄弟节点只尝试加锁：插入沿右链接从左向右加锁，逆序阻塞等待可能死锁。
+    // 加锁失败或兄弟间存在未安装的分裂（右链接不相邻）时放弃调整，节点只是暂时偏空
+    BaseNode<Key>* left_sibling = nullptr;
+    BaseNode<Key>* right_sibling = nullptr;
     if (child_index > 0) {
-        BaseNode<Key>* left_sibling = parent->children[child_index - 1];
-        if (left_sibling->size > (order + 1) / 2) {
-            if (node->is_leaf) {
-                LeafNode<Key>* leaf = static_cast<LeafNode<Key>*>(node);
-                LeafNode<Key>* left_leaf = static_cast<LeafNode<Key>*>(left_sibling);
-
-                // 借用左兄弟的最后一个键值对
-                leaf->keys.insert(leaf->keys.begin(), left_leaf->keys.back());
-                leaf->values.insert(leaf->values.begin(), left_leaf->values.back());
-                leaf->size++;
-
-                left_leaf->keys.pop_back();
-                left_leaf->values.pop_back();
-                left_leaf->size--;
-
-                // 更新父节点键
-                parent->keys[child_index - 1] = leaf->keys[0];
+        BaseNode<Key>* sibling = parent->children[child_index - 1];
+        if (sibling->try_write_lock()) {
+            if (right_link(sibling) == node) {
+                left_sibling = sibling;
             } else {
-                parent->borrow_from_left(child_index, order);
+                sibling->write_unlock();
             }
-            return;
         }
     }
-
-    // 尝试从右兄弟借用
     if (child_index < parent->children.size() - 1) {
-        BaseNode<Key>* right_sibling = parent->children[child_index + 1];
-        if (right_sibling->size > (order + 1) / 2) {
-            if (node->is_leaf) {
-                LeafNode<Key>* leaf = static_cast<LeafNode<Key>*>(node);
-                LeafNode<Key>* right_leaf = static_cast<LeafNode<Key>*>(right_sibling);
-
-                // 借用右兄弟的第一个键值对
-                leaf->keys.push_back(right_leaf->keys[0]);
-                leaf->values.push_back(right_leaf->values[0]);
-                leaf->size++;
+        BaseNode<Key>* sibling = parent->children[child_index + 1];
+        if (right_link(node) == sibling && sibling->try_write_lock()) {
+            right_sibling = sibling;
+        }
+    }
 
-                right_leaf->keys.erase(right_leaf->keys.begin());
-                right_leaf->values.erase(right_leaf->values.begin());
-                right_leaf->size--;
+    // 借用与合并只修改已加锁的节点，计数模式下在count_mutex独占锁内进行
+    std::unique_lock<std::shared_mutex> count_lock(count_mutex, std::defer_lock);
+    if (left_sibling || right_sibling) begin_count_change(count_lock);
 
-                // 更新父节点键
-                parent->keys[child_index] = right_leaf->keys[0];
-            } else {
-                parent->borrow_from_right(child_index, order);
+    // 内部节点合并时还要下移父节点中的分隔键，合并后超过阶数则不合并，避免留下过载节点
+    int merge_extra = node->is_leaf ? 0 : 1;
+    bool merged = false;
+    if (left_sibling && left_sibling->size > (node_order() + 1) / 2) {
+        // 尝试从左兄弟借用
+        if (node->is_leaf) {
+            LeafNode<Key>* leaf = static_cast<LeafNode<Key>*>(node);
+            LeafNode<Key>* left_leaf = static_cast<LeafNode<Key>*>(left_sibling);
+
+            // 借用左兄弟的最后一个键值对
+            leaf->keys.insert(leaf->keys.begin(), left_leaf->keys.back());
+            leaf->values.insert(leaf->values.begin(), left_leaf->values.back());
+            leaf->size++;
+
+            left_leaf->keys.pop_back();
+            left_leaf->values.pop_back();
+            left_leaf->size--;
+
+            // 更新父节点键和左兄弟上界
+            parent->keys.set(child_index - 1, leaf->keys[0]);
+            left_leaf->high_key = leaf->keys[0];
+            leaf->dirty = left_leaf->dirty = true;
+            leaf->subtree_count = leaf->size;
+            left_leaf->subtree_count = left_leaf->size;
+        } else {
+            parent->borrow_from_left(child_index, node_order());
+            if (counted) {
+                int64_t moved = adopt_split_chain(static_cast<InternalNode<Key>*>(node)->children[0], left_sibling);
+                left_sibling->subtree_count -= moved;
+                node->subtree_count += moved;
             }
-            return;
         }
-    }
-
-    // 合并节点
-    if (child_index > 0) {
-        // 与左兄弟合并
+    } else if (right_sibling && right_sibling->size > (node_order() + 1) / 2) {
+        // 尝试从右兄弟借用
+        if (node->is_leaf) {
+            LeafNode<Key>* leaf = static_cast<LeafNode<Key>*>(node);
+            LeafNode<Key>* right_leaf = static_cast<LeafNode<Key>*>(right_sibling);
+
+            // 借用右兄弟的第一个键值对
+            leaf->keys.push_back(right_leaf->keys[0]);
+            leaf->values.push_back(right_leaf->values[0]);
+            leaf->size++;
+
+            right_leaf->keys.erase(right_leaf->keys.begin());
+            right_leaf->values.erase(right_leaf->values.begin());
+            right_leaf->size--;
+
+            // 更新父节点键和本节点上界
+            parent->keys.set(child_index, right_leaf->keys[0]);
+            leaf->high_key = right_leaf->keys[0];
+            leaf->dirty = right_leaf->dirty = true;
+            leaf->subtree_count = leaf->size;
+            right_leaf->subtree_count = right_leaf->size;
+        } else {
+            parent->borrow_from_right(child_index, node_order());
+            if (counted) {
+                InternalNode<Key>* inode = static_cast<InternalNode<Key>*>(node);
+                InternalNode<Key>* right_inode = static_cast<InternalNode<Key>*>(right_sibling);
+                int64_t moved = adopt_split_chain(inode->children[inode->size], right_sibling, right_inode->children[0]);
+                right_sibling->subtree_count -= moved;
+                node->subtree_count += moved;
+            }
+        }
+    } else if (left_sibling && left_sibling->size + node->size + merge_extra <= node_order()) {
+        // 与左兄弟合并（本节点被摘除，仍在调用方的加锁队列中，当前线程的epoch登记保证其不被释放）
         merge_nodes(parent, child_index - 1, node->is_leaf);
-    } else {
+        merged = true;
+    } else if (right_sibling && node->size + right_sibling->size + merge_extra <= node_order()) {
         // 与右兄弟合并
         merge_nodes(parent, child_index, node->is_leaf);
+        merged = true;
     }
 
-    // 递归检查父节点
-    if (parent->is_underloaded(order) && parent != root) {
-        handle_underflow(parent);
-    } else if (parent == root && parent->size == 0) {
-        // 根节点为空，更新根节点
-        root = parent->children[0];
-        root->parent = nullptr;
+    bool parent_underflow = merged && parent != root && parent->is_underloaded(node_order());
+    if (merged && parent == root && parent->size == 0 && !right_link(parent->children[0])) {
+        // 根节点为空，更新根节点（唯一子节点有未安装的分裂时保留旧根，等待分隔键安装）
+        BaseNode<Key>* new_root = parent->children[0];
+        new_root->parent = nullptr;
+        root = new_root;
         parent->children.clear();
 
-        delete parent;
+        retire_node(parent);
     }
+    end_count_change(count_lock);
+
+    // 递归检查父节点
+    if (parent_underflow) handle_underflow(parent);
+
+    if (left_sibling) left_sibling->write_unlock();
+    if (right_sibling) right_sibling->write_unlock();
 }
 
 // 合并节点
-template <typename Key>
-void BPlusTree<Key>::merge_nodes(InternalNode<Key>* parent, int left_index, bool is_leaf) {
+template <typename Key, int Order>
+void BPlusTree<Key, Order>::merge_nodes(InternalNode<Key>* parent, int left_index, bool is_leaf) {
     BaseNode<Key>* left = parent->children[left_index];
     BaseNode<Key>* right = parent->children[left_index + 1];
 
@@ -652,14 +2250,18 @@ void BPlusTree<Key>::merge_nodes(InternalNode<Key>* parent, int left_index, bool
         left_leaf->values.insert(left_leaf->values.end(), right_leaf->values.begin(), right_leaf->values.end());
         left_leaf->size += right_leaf->size;
 
-        // 更新叶子链表
+        // 更新叶子链表和上界
+        left_leaf->high_key = right_leaf->high_key;
+        left_leaf->has_high_key = right_leaf->has_high_key;
         left_leaf->next = right_leaf->next;
-        if (right_leaf->next) right_leaf->next->prev = left_leaf;
+        if (right_leaf->next) right_leaf->next->prev.store(left_leaf, std::memory_order_release);
+        left_leaf->dirty = true;
+        left_leaf->subtree_count = left_leaf->size;
 
         // 删除右节点
         right_leaf->next = nullptr;
-        right_leaf->prev = nullptr;
-        delete right_leaf;
+        right_leaf->prev.store(nullptr, std::memory_order_release);
+        retire_node(right_leaf);
     } else {
         InternalNode<Key>* left_internal = static_cast<InternalNode<Key>*>(left);
         InternalNode<Key>* right_internal = static_cast<InternalNode<Key>*>(right);
@@ -673,36 +2275,57 @@ void BPlusTree<Key>::merge_nodes(InternalNode<Key>* parent, int left_index, bool
                                        right_internal->children.end());
         left_internal->size += right_internal->size + 1;
 
-        // 更新子节点的父指针
+        // 更新子节点的父指针，计数模式下其后未安装的分裂节点一并移到左节点
         for (auto child : right_internal->children) {
             child->parent = left_internal;
         }
+        if (counted) {
+            for (auto child : right_internal->children) adopt_split_chain(child, right_internal);
+            left_internal->subtree_count += right_internal->subtree_count;
+        }
+
+        // 更新右链接和上界
+        left_internal->high_key = right_internal->high_key;
+        left_internal->has_high_key = right_internal->has_high_key;
+        left_internal->right = right_internal->right;
 
         // 删除右节点
         right_internal->children.clear();
-        delete right_internal;
+        right_internal->right = nullptr;
+        retire_node(right_internal);
     }
 
     // 从父节点中删除键和子节点指针
-    parent->remove_from_node(left_index, order);
+    parent->remove_from_node(left_index, node_order());
+}
+
+// 摘除节点：乐观读者可能仍持有其指针，交给epoch回收延迟释放
+template <typename Key, int Order>
+void BPlusTree<Key, Order>::retire_node(BaseNode<Key>* node) {
+    epoch_manager.retire(node, &BPlusTree<Key, Order>::delete_node);
+}
+
+template <typename Key, int Order>
+void BPlusTree<Key, Order>::delete_node(void* node) {
+    delete static_cast<BaseNode<Key>*>(node);
 }
 
 // 序列化键（特化模板处理不同类型）
-template <typename Key>
-void BPlusTree<Key>::serialize_key(std::ofstream& file, const int& key) {
-    file.write(reinterpret_cast<const char*>(&key), sizeof(key));
+template <typename Key, int Order>
+void BPlusTree<Key, Order>::serialize_key(BufferedFileWriter& file, const int& key) {
+    file.put(key);
 }
 
-template <typename Key>
-void BPlusTree<Key>::serialize_key(std::ofstream& file, const std::string& key) {
+template <typename Key, int Order>
+void BPlusTree<Key, Order>::serialize_key(BufferedFileWriter& file, const std::string& key) {
     int32_t length = static_cast<int32_t>(key.size());
-    file.write(reinterpret_cast<const char*>(&length), sizeof(length));
-    file.write(key.c_str(), length);
+    file.put(length);
+    file.write(key.data(), length);
 }
 
 // 反序列化键（特化模板处理不同类型）
-template <typename Key>
-Key BPlusTree<Key>::deserialize_key(std::ifstream& file) {
+template <typename Key, int Order>
+Key BPlusTree<Key, Order>::deserialize_key(std::ifstream& file) {
     if constexpr (std::is_same<Key, int>::value) {
         int key;
         file.read(reinterpret_cast<char*>(&key), sizeof(key));
@@ -720,4 +2343,10 @@ Key BPlusTree<Key>::deserialize_key(std::ifstream& file) {
 }
 // 显式实例化
 template class BPlusTree<int>;
-template class BPlusTree<std::string>;
\ No newline at end of file
+template class BPlusTree<std::string>;
+template class BPlusTree<int, 16>;
+template class BPlusTree<int, 64>;
+template class BPlusTree<int, 128>;
+template class BPlusTree<int, 256>;
+template class BPlusTree<std::string, 16>;
+template class BPlusTree<std::string, 64>;
\ No newline at end of file
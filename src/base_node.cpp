@@ -1,9 +1,30 @@
 #include"base_node.h"
+#include"simd_search.h"
+
+#include<thread>
+
+// 节点内存块按缓存行对齐
+static const std::size_t node_alignment = 64;
+
+template <typename Key>
+BaseNode<Key>::BaseNode(bool is_leaf, int order, void* key_storage) : 
+    is_leaf(is_leaf), level(0), size(0), keys(key_storage, order + 1), version(0), parent(nullptr), has_high_key(false), subtree_count(0) {
+    // 容量为过载时的order+1，之后不再扩容，乐观读者不会读到已释放的缓冲区
+}
+
+template <typename Key>
+void* BaseNode<Key>::operator new(std::size_t size, NodeBlock block) {
+    return ::operator new(std::max(size, block.bytes), std::align_val_t(node_alignment));
+}
 
 template <typename Key>
-BaseNode<Key>::BaseNode(bool is_leaf) : 
-    is_leaf(is_leaf), size(0), parent(nullptr) {
-    keys.reserve(1);
+void BaseNode<Key>::operator delete(void* ptr, NodeBlock) {
+    ::operator delete(ptr, std::align_val_t(node_alignment));
+}
+
+template <typename Key>
+void BaseNode<Key>::operator delete(void* ptr) {
+    ::operator delete(ptr, std::align_val_t(node_alignment));
 }
 
 template <typename Key>
@@ -12,19 +33,65 @@ int BaseNode<Key>::find_index(const Key& key) const {
     return it - keys.begin();
 }
 
+template <>
+int BaseNode<int>::find_index(const int& key) const {
+    return simd_lower_bound(keys.begin(), size, key);
+}
+
+template <>
+int BaseNode<std::string>::find_index(const std::string& key) const {
+    return keys.lower_bound(key);
+}
+
+template <typename Key>
+bool BaseNode<Key>::beyond_high_key(const Key& key) const {
+    return has_high_key && !(key < high_key);
+}
+
+template <typename Key>
+void BaseNode<Key>::write_lock() {
+    mutex.lock();
+    begin_write();
+}
+
+template <typename Key>
+void BaseNode<Key>::write_unlock() {
+    end_write();
+    mutex.unlock();
+}
+
+template <typename Key>
+bool BaseNode<Key>::try_write_lock() {
+    if (!mutex.try_lock()) return false;
+    begin_write();
+    return true;
+}
+
+template <typename Key>
+void BaseNode<Key>::begin_write() {
+    version.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
 template <typename Key>
-bool BaseNode<Key>::is_overloaded(int order) const {
-    return size > order;
+void BaseNode<Key>::end_write() {
+    version.fetch_add(1, std::memory_order_release);
 }
 
 template <typename Key>
-bool BaseNode<Key>::is_underloaded(int order) const {
-    return size < (order + 1) / 2;
+uint64_t BaseNode<Key>::read_version() const {
+    uint64_t v = version.load(std::memory_order_acquire);
+    while (v & 1) {
+        std::this_thread::yield();
+        v = version.load(std::memory_order_acquire);
+    }
+    return v;
 }
 
 template <typename Key>
-bool BaseNode<Key>::is_safe(int order) const {
-    return ((size < order) && (size > ((order + 1) / 2)));
+bool BaseNode<Key>::validate(uint64_t read_version) const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return version.load(std::memory_order_relaxed) == read_version;
 }
 
 // 显式实例化
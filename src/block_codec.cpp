@@ -0,0 +1,156 @@
+#include "block_codec.h"
+
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+#ifdef BPT_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+
+void put_varint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+// 带边界检查的顺序读取
+struct BlockReader {
+    const char* pos;
+    const char* end;
+
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (pos == end) throw std::runtime_error("Corrupted compressed block");
+            uint8_t byte = static_cast<uint8_t>(*pos++);
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return value;
+        }
+        throw std::runtime_error("Corrupted compressed block");
+    }
+
+    const char* bytes(uint64_t size) {
+        if (static_cast<uint64_t>(end - pos) < size) throw std::runtime_error("Corrupted compressed block");
+        const char* data = pos;
+        pos += size;
+        return data;
+    }
+};
+
+std::size_t common_prefix(const std::string& a, const std::string& b) {
+    std::size_t n = std::min(a.size(), b.size()), i = 0;
+    while (i < n && a[i] == b[i]) i++;
+    return i;
+}
+
+}  // namespace
+
+bool codec_available(SnapshotCodec codec) {
+    if (codec == SnapshotCodec::none) return true;
+#ifdef BPT_HAVE_ZLIB
+    if (codec == SnapshotCodec::zlib) return true;
+#endif
+    return false;
+}
+
+template <typename Key>
+void encode_block(std::string& out, const std::vector<std::pair<Key, uint64_t>>& entries) {
+    out.clear();
+    for (size_t i = 0; i < entries.size(); i++) {
+        const Key& key = entries[i].first;
+        if constexpr (std::is_same<Key, int>::value) {
+            if (i == 0) {
+                put_varint(out, (static_cast<uint64_t>(key) << 1) ^ static_cast<uint64_t>(key >> 31));
+            } else {
+                put_varint(out, static_cast<uint64_t>(static_cast<int64_t>(key) - entries[i - 1].first));
+            }
+        } else {
+            std::size_t shared = i == 0 ? 0 : common_prefix(entries[i - 1].first, key);
+            put_varint(out, shared);
+            put_varint(out, key.size() - shared);
+            out.append(key, shared, std::string::npos);
+        }
+    }
+    for (const auto& entry : entries) put_varint(out, entry.second);
+}
+
+template <typename Key>
+void decode_block(const char* data, std::size_t size, std::pair<Key, uint64_t>* first, uint32_t count) {
+    BlockReader reader{data, data + size};
+    for (uint32_t i = 0; i < count; i++) {
+        Key& key = first[i].first;
+        if constexpr (std::is_same<Key, int>::value) {
+            uint64_t raw = reader.varint();
+            int64_t value;
+            if (i == 0) {
+                value = static_cast<int64_t>(raw >> 1) ^ -static_cast<int64_t>(raw & 1);
+            } else {
+                if (raw > std::numeric_limits<uint32_t>::max()) throw std::runtime_error("Corrupted compressed block");
+                value = static_cast<int64_t>(first[i - 1].first) + static_cast<int64_t>(raw);
+            }
+            if (value < std::numeric_limits<int>::min() || value > std::numeric_limits<int>::max()) {
+                throw std::runtime_error("Corrupted compressed block");
+            }
+            key = static_cast<int>(value);
+        } else {
+            uint64_t shared = reader.varint();
+            uint64_t suffix = reader.varint();
+            if (i == 0 ? shared != 0 : shared > first[i - 1].first.size()) {
+                throw std::runtime_error("Corrupted compressed block");
+            }
+            const char* bytes = reader.bytes(suffix);
+            key.reserve(shared + suffix);
+            if (i > 0)
+                key.assign(first[i - 1].first, 0, shared);
+            else
+                key.clear();
+            key.append(bytes, suffix);
+        }
+    }
+    for (uint32_t i = 0; i < count; i++) first[i].second = reader.varint();
+    if (reader.pos != reader.end) throw std::runtime_error("Corrupted compressed block");
+}
+
+bool compress_block(SnapshotCodec codec, const std::string& raw, std::string& out) {
+    if (codec == SnapshotCodec::none) return false;
+#ifdef BPT_HAVE_ZLIB
+    if (codec == SnapshotCodec::zlib) {
+        uLongf size = compressBound(raw.size());
+        out.resize(size);
+        if (compress2(reinterpret_cast<Bytef*>(&out[0]), &size, reinterpret_cast<const Bytef*>(raw.data()),
+                      raw.size(), Z_DEFAULT_COMPRESSION) != Z_OK) {
+            throw std::runtime_error("Failed to compress block");
+        }
+        out.resize(size);
+        return size < raw.size();
+    }
+#endif
+    throw std::runtime_error("Snapshot codec not available");
+}
+
+void decompress_block(SnapshotCodec codec, const char* data, std::size_t size, std::size_t raw_size,
+                      std::string& out) {
+#ifdef BPT_HAVE_ZLIB
+    if (codec == SnapshotCodec::zlib) {
+        out.resize(raw_size);
+        uLongf length = raw_size;
+        if (uncompress(reinterpret_cast<Bytef*>(&out[0]), &length, reinterpret_cast<const Bytef*>(data), size) !=
+                Z_OK ||
+            length != raw_size) {
+            throw std::runtime_error("Corrupted compressed block");
+        }
+        return;
+    }
+#endif
+    throw std::runtime_error("Snapshot codec not available");
+}
+
+template void encode_block<int>(std::string&, const std::vector<std::pair<int, uint64_t>>&);
+template void encode_block<std::string>(std::string&, const std::vector<std::pair<std::string, uint64_t>>&);
+template void decode_block<int>(const char*, std::size_t, std::pair<int, uint64_t>*, uint32_t);
+template void decode_block<std::string>(const char*, std::size_t, std::pair<std::string, uint64_t>*, uint32_t);
@@ -0,0 +1,135 @@
+#include "buffer_pool.h"
+
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+PageHandle::PageHandle(BufferPool* pool, int frame, uint64_t page_id, char* ptr)
+    : pool(pool), frame(frame), page_id(page_id), ptr(ptr) {}
+
+PageHandle::PageHandle(PageHandle&& other) noexcept
+    : pool(other.pool), frame(other.frame), page_id(other.page_id), ptr(other.ptr), dirty(other.dirty) {
+    other.pool = nullptr;
+    other.ptr = nullptr;
+}
+
+PageHandle& PageHandle::operator=(PageHandle&& other) noexcept {
+    if (this != &other) {
+        release();
+        pool = other.pool;
+        frame = other.frame;
+        page_id = other.page_id;
+        ptr = other.ptr;
+        dirty = other.dirty;
+        other.pool = nullptr;
+        other.ptr = nullptr;
+    }
+    return *this;
+}
+
+PageHandle::~PageHandle() { release(); }
+
+void PageHandle::release() {
+    if (pool && frame >= 0) pool->unpin(frame, dirty);
+    pool = nullptr;
+    ptr = nullptr;
+    dirty = false;
+}
+
+BufferPool::BufferPool(PageFile& file, std::size_t capacity)
+    : file(file), frames(capacity), buffer(nullptr), clock_hand(0), miss_count(0) {
+    if (capacity > 0) {
+        buffer = static_cast<char*>(
+            ::operator new(capacity * PageFile::page_size, std::align_val_t(PageFile::page_size)));
+    }
+}
+
+BufferPool::~BufferPool() {
+    try {
+        flush_all();
+    } catch (const std::exception&) {
+        // 析构中无法上报写回失败
+    }
+    if (buffer) ::operator delete(buffer, std::align_val_t(PageFile::page_size));
+}
+
+PageHandle BufferPool::fetch(uint64_t id) {
+    if (frames.empty()) return PageHandle(this, -1, id, file.page(id));
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = page_table.find(id);
+    if (it != page_table.end()) {
+        Frame& frame = frames[it->second];
+        frame.pin_count++;
+        frame.referenced = true;
+        return PageHandle(this, it->second, id, frame_data(it->second));
+    }
+
+    int victim = evict();
+    file.read_page(id, frame_data(victim));
+    miss_count++;
+    frames[victim] = Frame{id, 1, false, true};
+    page_table[id] = victim;
+    return PageHandle(this, victim, id, frame_data(victim));
+}
+
+PageHandle BufferPool::allocate() {
+    if (frames.empty()) {
+        uint64_t id = file.allocate();
+        return PageHandle(this, -1, id, file.page(id));
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    int victim = evict();
+    uint64_t id = file.allocate();
+    std::memset(frame_data(victim), 0, PageFile::page_size);
+    frames[victim] = Frame{id, 1, true, true};
+    page_table[id] = victim;
+    return PageHandle(this, victim, id, frame_data(victim));
+}
+
+// CLOCK：跳过被固定的页帧，引用位为1的页帧清零后再给一次机会。
+// 调用方持有mutex；选中的页帧若为脏页则先写回
+int BufferPool::evict() {
+    for (std::size_t step = 0; step < frames.size() * 2; step++) {
+        int index = static_cast<int>(clock_hand);
+        clock_hand = (clock_hand + 1) % frames.size();
+        Frame& frame = frames[index];
+        if (frame.pin_count > 0) continue;
+        if (frame.referenced) {
+            frame.referenced = false;
+            continue;
+        }
+        if (frame.page_id != PageFile::invalid_page) {
+            if (frame.dirty) file.write_page(frame.page_id, frame_data(index));
+            page_table.erase(frame.page_id);
+        }
+        frame = Frame{};
+        return index;
+    }
+    throw std::runtime_error("Buffer pool exhausted: all frames are pinned");
+}
+
+void BufferPool::unpin(int frame, bool dirty) {
+    std::lock_guard<std::mutex> lock(mutex);
+    frames[frame].pin_count--;
+    frames[frame].dirty = frames[frame].dirty || dirty;
+}
+
+void BufferPool::flush_all() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (std::size_t i = 0; i < frames.size(); i++) {
+            if (frames[i].page_id != PageFile::invalid_page && frames[i].dirty) {
+                file.write_page(frames[i].page_id, frame_data(static_cast<int>(i)));
+                frames[i].dirty = false;
+            }
+        }
+    }
+    file.sync();
+}
+
+uint64_t BufferPool::misses() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return miss_count;
+}
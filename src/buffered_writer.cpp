@@ -0,0 +1,85 @@
+#include "buffered_writer.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <stdexcept>
+
+BufferedFileWriter::BufferedFileWriter(const std::string& path, std::size_t buffer_size)
+    : capacity(buffer_size), flushed(0) {
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) throw std::runtime_error("Failed to open file for writing: " + path);
+    buffer.reserve(capacity);
+}
+
+BufferedFileWriter::~BufferedFileWriter() {
+    try {
+        close();
+    } catch (const std::exception&) {
+        // 析构中无法上报写出失败
+    }
+}
+
+void BufferedFileWriter::write(const void* data, std::size_t size) {
+    if (buffer.size() + size > capacity) flush();
+    const char* bytes = static_cast<const char*>(data);
+    if (size >= capacity) {
+        // 不小于缓冲大小的块不经过缓冲，直接写出
+        write_all(bytes, size);
+        flushed += size;
+        return;
+    }
+    buffer.insert(buffer.end(), bytes, bytes + size);
+}
+
+void BufferedFileWriter::write_all(const char* data, std::size_t size) {
+    while (size > 0) {
+        ssize_t n = ::write(fd, data, size);
+        if (n < 0) throw std::runtime_error("Failed to write file");
+        data += n;
+        size -= n;
+    }
+}
+
+void BufferedFileWriter::patch(uint64_t position, const void* data, std::size_t size) {
+    if (position + size > this->position()) throw std::runtime_error("Patch beyond written data");
+    const char* bytes = static_cast<const char*>(data);
+    // 可能跨越已写出与缓冲两部分
+    while (size > 0 && position < flushed) {
+        std::size_t part = std::min<uint64_t>(size, flushed - position);
+        if (::pwrite(fd, bytes, part, static_cast<off_t>(position)) != static_cast<ssize_t>(part)) {
+            throw std::runtime_error("Failed to patch file");
+        }
+        position += part;
+        bytes += part;
+        size -= part;
+    }
+    if (size > 0) std::memcpy(buffer.data() + (position - flushed), bytes, size);
+}
+
+void BufferedFileWriter::flush() {
+    if (fd < 0) throw std::runtime_error("Writer is closed");
+    write_all(buffer.data(), buffer.size());
+    flushed += buffer.size();
+    buffer.clear();
+}
+
+void BufferedFileWriter::sync() {
+    flush();
+    if (::fsync(fd) != 0) throw std::runtime_error("Failed to sync file");
+}
+
+void BufferedFileWriter::close() {
+    if (fd < 0) return;
+    // 写出失败时同样关闭文件，再上报错误
+    try {
+        flush();
+    } catch (...) {
+        ::close(fd);
+        fd = -1;
+        throw;
+    }
+    ::close(fd);
+    fd = -1;
+}
@@ -0,0 +1,395 @@
+#include "disk_b_plus_tree.h"
+
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+
+namespace {
+
+// 键在页内的定长编码
+template <typename Key>
+struct PageKey;
+
+template <>
+struct PageKey<int> {
+    static constexpr std::size_t width = sizeof(int);
+    static constexpr int32_t type_id = 0;
+
+    static void store(char* slot, const int& key) { std::memcpy(slot, &key, width); }
+    static int load(const char* slot) {
+        int key;
+        std::memcpy(&key, slot, width);
+        return key;
+    }
+};
+
+// 1字节长度 + 最多31字节内容
+template <>
+struct PageKey<std::string> {
+    static constexpr std::size_t width = 32;
+    static constexpr int32_t type_id = 1;
+
+    static void store(char* slot, const std::string& key) {
+        if (key.size() >= width) throw std::runtime_error("Key too long for disk tree");
+        slot[0] = static_cast<char>(key.size());
+        std::memcpy(slot + 1, key.data(), key.size());
+    }
+    static std::string load(const char* slot) {
+        return std::string(slot + 1, static_cast<unsigned char>(slot[0]));
+    }
+};
+
+// 树的元数据，存放在页文件头之后
+struct TreeMeta {
+    uint32_t initialized;
+    int32_t key_type;
+    uint64_t root;
+};
+
+// 页头：是否叶子、键数、叶子的后继页号
+struct PageHeader {
+    uint8_t is_leaf;
+    uint8_t reserved;
+    uint16_t size;
+    uint32_t reserved2;
+    uint64_t next;
+};
+
+// 页内容的访问视图。叶子页：键数组 + 值数组；内部页：键数组 + 子页号数组（多一个）
+template <typename Key>
+class PageNode {
+   public:
+    static constexpr int leaf_capacity =
+        static_cast<int>((PageFile::page_size - sizeof(PageHeader)) / (PageKey<Key>::width + sizeof(uint64_t)));
+    static constexpr int internal_capacity = static_cast<int>(
+        (PageFile::page_size - sizeof(PageHeader) - sizeof(uint64_t)) / (PageKey<Key>::width + sizeof(uint64_t)));
+
+    explicit PageNode(char* data) : data(data) {}
+
+    void init(bool leaf) {
+        header()->is_leaf = leaf;
+        header()->size = 0;
+        header()->next = PageFile::invalid_page;
+    }
+
+    bool is_leaf() const { return header()->is_leaf; }
+    int size() const { return header()->size; }
+    void set_size(int size) { header()->size = static_cast<uint16_t>(size); }
+    uint64_t next() const { return header()->next; }
+    void set_next(uint64_t id) { header()->next = id; }
+    int capacity() const { return is_leaf() ? leaf_capacity : internal_capacity; }
+
+    Key key(int i) const { return PageKey<Key>::load(key_slot(i)); }
+    void set_key(int i, const Key& key) { PageKey<Key>::store(key_slot(i), key); }
+    // 叶子的值与内部节点的子页号共用同一数组
+    uint64_t slot(int i) const {
+        uint64_t v;
+        std::memcpy(&v, slot_ptr(i), sizeof(v));
+        return v;
+    }
+    void set_slot(int i, uint64_t v) { std::memcpy(slot_ptr(i), &v, sizeof(v)); }
+
+    // 第一个不小于key的位置
+    int lower_bound(const Key& key) const {
+        int lo = 0, hi = size();
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (this->key(mid) < key)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return lo;
+    }
+    // 第一个大于key的位置，即内部节点中key所在的子节点下标
+    int upper_bound(const Key& key) const {
+        int lo = 0, hi = size();
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (key < this->key(mid))
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+        return lo;
+    }
+
+    // 在index处插入键，叶子同时插入值，内部节点在index+1处插入右子页号
+    void insert_at(int index, const Key& key, uint64_t v) {
+        int n = size();
+        int slot_index = is_leaf() ? index : index + 1;
+        int slot_count = is_leaf() ? n : n + 1;
+        std::memmove(key_slot(index + 1), key_slot(index), (n - index) * PageKey<Key>::width);
+        std::memmove(slot_ptr(slot_index + 1), slot_ptr(slot_index), (slot_count - slot_index) * sizeof(uint64_t));
+        set_key(index, key);
+        set_slot(slot_index, v);
+        set_size(n + 1);
+    }
+
+    void remove_at(int index) {
+        int n = size();
+        std::memmove(key_slot(index), key_slot(index + 1), (n - index - 1) * PageKey<Key>::width);
+        std::memmove(slot_ptr(index), slot_ptr(index + 1), (n - index - 1) * sizeof(uint64_t));
+        set_size(n - 1);
+    }
+
+   private:
+    PageHeader* header() const { return reinterpret_cast<PageHeader*>(data); }
+    char* key_slot(int i) const { return data + sizeof(PageHeader) + i * PageKey<Key>::width; }
+    char* slot_ptr(int i) const {
+        return data + sizeof(PageHeader) + capacity() * PageKey<Key>::width + i * sizeof(uint64_t);
+    }
+
+    char* data;
+};
+
+}  // namespace
+
+template <typename Key>
+DiskBPlusTree<Key>::DiskBPlusTree(const std::string& path, std::size_t pool_pages)
+    : file(path), pool(file, pool_pages) {
+    if (pool_pages > 0 && pool_pages < 4) throw std::runtime_error("Buffer pool needs at least 4 pages");
+    const TreeMeta* meta = reinterpret_cast<const TreeMeta*>(file.user_meta());
+    if (!meta->initialized) {
+        {
+            PageHandle page = pool.allocate();
+            PageNode<Key>(page.data()).init(true);
+            root = page.id();
+        }
+        // 根页写出之后才标记为已初始化
+        publish_root();
+        return;
+    }
+    if (meta->key_type != PageKey<Key>::type_id) throw std::runtime_error("Disk tree key type does not match");
+    root = meta->root;
+}
+
+template <typename Key>
+DiskBPlusTree<Key>::~DiskBPlusTree() {
+    try {
+        sync();
+    } catch (const std::exception&) {
+        // 析构中无法上报写回失败，文件头仍指向上一次sync时的根
+    }
+}
+
+template <typename Key>
+uint64_t DiskBPlusTree<Key>::root_page() const {
+    return root;
+}
+
+template <typename Key>
+void DiskBPlusTree<Key>::set_root_page(uint64_t id) {
+    root = id;
+}
+
+// 第0页由映射直接修改，内核可能随时写回，因此必须先让根页号引用的所有页面落盘
+template <typename Key>
+void DiskBPlusTree<Key>::publish_root() {
+    pool.flush_all();
+    TreeMeta* meta = reinterpret_cast<TreeMeta*>(file.user_meta());
+    if (meta->initialized && meta->root == root) return;
+    meta->key_type = PageKey<Key>::type_id;
+    meta->root = root;
+    meta->initialized = 1;
+    file.sync();
+}
+
+template <typename Key>
+int DiskBPlusTree<Key>::leaf_capacity() {
+    return PageNode<Key>::leaf_capacity;
+}
+
+template <typename Key>
+int DiskBPlusTree<Key>::internal_capacity() {
+    return PageNode<Key>::internal_capacity;
+}
+
+// 下降过程中只固定当前页
+template <typename Key>
+PageHandle DiskBPlusTree<Key>::fetch_leaf(const Key& key) const {
+    PageHandle page = pool.fetch(root_page());
+    while (!PageNode<Key>(page.data()).is_leaf()) {
+        PageNode<Key> node(page.data());
+        page = pool.fetch(node.slot(node.upper_bound(key)));
+    }
+    return page;
+}
+
+template <typename Key>
+void DiskBPlusTree<Key>::insert(const Key& key, uint64_t value) {
+    // 先检查键能否编码，避免移动了页内条目之后才失败
+    char probe[PageKey<Key>::width];
+    PageKey<Key>::store(probe, key);
+
+    std::unique_lock<std::shared_mutex> lock(tree_mutex);
+    uint64_t root = root_page();
+    auto split = insert_into(root, key, value);
+    if (!split) return;
+
+    // 根分裂，树长高一层
+    PageHandle page = pool.allocate();
+    PageNode<Key> node(page.data());
+    node.init(false);
+    node.set_key(0, split->key);
+    node.set_slot(0, root);
+    node.set_slot(1, split->right);
+    node.set_size(1);
+    set_root_page(page.id());
+}
+
+// 递归前释放当前页：既不占用缓冲池页帧，也避免直接映射模式下分配新页使句柄失效
+template <typename Key>
+auto DiskBPlusTree<Key>::insert_into(uint64_t page_id, const Key& key, uint64_t value) -> std::optional<Split> {
+    int index = 0;
+    uint64_t child = PageFile::invalid_page;
+    {
+        PageHandle page = pool.fetch(page_id);
+        PageNode<Key> node(page.data());
+        if (node.is_leaf()) {
+            int pos = node.lower_bound(key);
+            if (pos < node.size() && node.key(pos) == key) {
+                node.set_slot(pos, value);
+                page.mark_dirty();
+                return std::nullopt;
+            }
+            if (node.size() < PageNode<Key>::leaf_capacity) {
+                node.insert_at(pos, key, value);
+                page.mark_dirty();
+                return std::nullopt;
+            }
+        } else {
+            index = node.upper_bound(key);
+            child = node.slot(index);
+        }
+    }
+    // 叶子已满
+    if (child == PageFile::invalid_page) return split_leaf(page_id, key, value);
+
+    auto child_split = insert_into(child, key, value);
+    if (!child_split) return std::nullopt;
+
+    {
+        PageHandle page = pool.fetch(page_id);
+        PageNode<Key> node(page.data());
+        if (node.size() < PageNode<Key>::internal_capacity) {
+            node.insert_at(index, child_split->key, child_split->right);
+            page.mark_dirty();
+            return std::nullopt;
+        }
+    }
+    return split_internal(page_id, index, *child_split);
+}
+
+template <typename Key>
+auto DiskBPlusTree<Key>::split_leaf(uint64_t page_id, const Key& key, uint64_t value) -> std::optional<Split> {
+    PageHandle right_page = pool.allocate();
+    PageHandle left_page = pool.fetch(page_id);
+    PageNode<Key> left(left_page.data());
+    PageNode<Key> right(right_page.data());
+    right.init(true);
+    left_page.mark_dirty();
+
+    int n = left.size();
+    int half = (n + 1) / 2;
+    for (int i = half; i < n; i++) {
+        right.set_key(i - half, left.key(i));
+        right.set_slot(i - half, left.slot(i));
+    }
+    right.set_size(n - half);
+    left.set_size(half);
+    right.set_next(left.next());
+    left.set_next(right_page.id());
+
+    int index = left.lower_bound(key);
+    if (index < half)
+        left.insert_at(index, key, value);
+    else
+        right.insert_at(right.lower_bound(key), key, value);
+    return Split{right.key(0), right_page.id()};
+}
+
+template <typename Key>
+auto DiskBPlusTree<Key>::split_internal(uint64_t page_id, int index, const Split& child_split) -> std::optional<Split> {
+    PageHandle right_page = pool.allocate();
+    PageHandle left_page = pool.fetch(page_id);
+    PageNode<Key> left(left_page.data());
+    PageNode<Key> right(right_page.data());
+    right.init(false);
+    left_page.mark_dirty();
+
+    // 先在临时数组中完成插入，再对半拆分
+    int n = left.size();
+    std::vector<Key> keys;
+    std::vector<uint64_t> children;
+    keys.reserve(n + 1);
+    children.reserve(n + 2);
+    for (int i = 0; i < n; i++) keys.push_back(left.key(i));
+    for (int i = 0; i <= n; i++) children.push_back(left.slot(i));
+    keys.insert(keys.begin() + index, child_split.key);
+    children.insert(children.begin() + index + 1, child_split.right);
+
+    int mid = (n + 1) / 2;
+    for (int i = 0; i < mid; i++) left.set_key(i, keys[i]);
+    for (int i = 0; i <= mid; i++) left.set_slot(i, children[i]);
+    left.set_size(mid);
+    for (int i = mid + 1; i <= n; i++) right.set_key(i - mid - 1, keys[i]);
+    for (int i = mid + 1; i <= n + 1; i++) right.set_slot(i - mid - 1, children[i]);
+    right.set_size(n - mid);
+    return Split{keys[mid], right_page.id()};
+}
+
+template <typename Key>
+void DiskBPlusTree<Key>::remove(const Key& key) {
+    std::unique_lock<std::shared_mutex> lock(tree_mutex);
+    PageHandle page = fetch_leaf(key);
+    PageNode<Key> leaf(page.data());
+    int index = leaf.lower_bound(key);
+    if (index < leaf.size() && leaf.key(index) == key) {
+        leaf.remove_at(index);
+        page.mark_dirty();
+    }
+}
+
+template <typename Key>
+uint64_t DiskBPlusTree<Key>::find(const Key& key) const {
+    std::shared_lock<std::shared_mutex> lock(tree_mutex);
+    PageHandle page = fetch_leaf(key);
+    PageNode<Key> leaf(page.data());
+    int index = leaf.lower_bound(key);
+    if (index < leaf.size() && leaf.key(index) == key) return leaf.slot(index);
+    return 0;
+}
+
+template <typename Key>
+std::vector<std::pair<Key, uint64_t>> DiskBPlusTree<Key>::range_find(const Key& start, const Key& end) const {
+    std::shared_lock<std::shared_mutex> lock(tree_mutex);
+    std::vector<std::pair<Key, uint64_t>> result;
+    PageHandle page = fetch_leaf(start);
+    int index = PageNode<Key>(page.data()).lower_bound(start);
+    while (true) {
+        PageNode<Key> leaf(page.data());
+        for (; index < leaf.size(); index++) {
+            Key key = leaf.key(index);
+            if (end < key) return result;
+            result.emplace_back(std::move(key), leaf.slot(index));
+        }
+        if (leaf.next() == PageFile::invalid_page) return result;
+        page = pool.fetch(leaf.next());
+        index = 0;
+    }
+}
+
+template <typename Key>
+void DiskBPlusTree<Key>::sync() {
+    std::unique_lock<std::shared_mutex> lock(tree_mutex);
+    publish_root();
+}
+
+template <typename Key>
+uint64_t DiskBPlusTree<Key>::page_misses() const {
+    return pool.misses();
+}
+
+template class DiskBPlusTree<int>;
+template class DiskBPlusTree<std::string>;
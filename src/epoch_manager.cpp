@@ -0,0 +1,80 @@
+#include "epoch_manager.h"
+
+#include <cstddef>
+
+// 每攒够这么多待回收节点尝试推进一次epoch
+static const std::size_t reclaim_threshold = 64;
+
+EpochManager::EpochManager() : global_epoch(1) {
+    for (auto& slot : slots) {
+        slot.epoch.store(0, std::memory_order_relaxed);
+        slot.depth = 0;
+    }
+}
+
+EpochManager::~EpochManager() {
+    reclaim_all();
+}
+
+void EpochManager::enter() {
+    Slot& slot = slots[acquire_thread_slot()];
+    if (slot.depth++ > 0) return;
+    // 登记必须先于之后对节点的任何读取对回收方可见
+    slot.epoch.store(global_epoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+}
+
+void EpochManager::exit() {
+    Slot& slot = slots[current_thread_slot()];
+    if (--slot.depth == 0) {
+        slot.epoch.store(0, std::memory_order_release);
+        // 节点要在摘除后epoch推进两次才能释放，只靠retire攒够阈值时推进，
+        // 摘除很少的线程永远等不到回收，因此有待回收节点时每次离开临界区都尝试推进和回收
+        if (!slot.retired.empty()) {
+            try_advance();
+            reclaim(slot);
+        }
+    }
+    release_thread_slot();
+}
+
+void EpochManager::retire(void* ptr, void (*deleter)(void*)) {
+    Slot& slot = slots[current_thread_slot()];
+    slot.retired.push_back({ptr, deleter, global_epoch.load(std::memory_order_seq_cst)});
+    if (slot.retired.size() >= reclaim_threshold) {
+        try_advance();
+        reclaim(slot);
+    }
+}
+
+void EpochManager::reclaim_all() {
+    for (auto& slot : slots) {
+        for (auto& item : slot.retired) {
+            item.deleter(item.ptr);
+        }
+        slot.retired.clear();
+    }
+}
+
+// 所有活跃线程都已进入当前epoch时推进全局epoch
+bool EpochManager::try_advance() {
+    uint64_t current = global_epoch.load(std::memory_order_seq_cst);
+    for (auto& slot : slots) {
+        uint64_t epoch = slot.epoch.load(std::memory_order_seq_cst);
+        if (epoch != 0 && epoch != current) return false;
+    }
+    return global_epoch.compare_exchange_strong(current, current + 1, std::memory_order_seq_cst);
+}
+
+// 释放摘除后epoch已推进两次的节点
+void EpochManager::reclaim(Slot& slot) {
+    uint64_t current = global_epoch.load(std::memory_order_seq_cst);
+    std::size_t kept = 0;
+    for (auto& item : slot.retired) {
+        if (item.epoch + 2 <= current) {
+            item.deleter(item.ptr);
+        } else {
+            slot.retired[kept++] = item;
+        }
+    }
+    slot.retired.resize(kept);
+}
@@ -1,10 +1,28 @@
 #include"internal_node.h"
 
+// 内存布局：[InternalNode][keys: order+1][children: order+2]
 template <typename Key>
-InternalNode<Key>::InternalNode() : BaseNode<Key>(false) {
-    this->children.reserve(1);
+std::size_t InternalNode<Key>::keys_offset() {
+    return node_align_up(sizeof(InternalNode), BaseNode<Key>::KeyArray::storage_alignment);
 }
 
+template <typename Key>
+std::size_t InternalNode<Key>::children_offset(int order) {
+    return node_align_up(keys_offset() + BaseNode<Key>::KeyArray::storage_bytes(order + 1), alignof(BaseNode<Key>*));
+}
+
+template <typename Key>
+InternalNode<Key>* InternalNode<Key>::create(int order) {
+    NodeBlock block{children_offset(order) + sizeof(BaseNode<Key>*) * (order + 2)};
+    return new (block) InternalNode(order);
+}
+
+template <typename Key>
+InternalNode<Key>::InternalNode(int order)
+    : BaseNode<Key>(false, order, reinterpret_cast<char*>(this) + keys_offset()),
+      children(reinterpret_cast<BaseNode<Key>**>(reinterpret_cast<char*>(this) + children_offset(order)), order + 2),
+      right(nullptr) {}
+
 template <typename Key>
 InternalNode<Key>::~InternalNode() {
     for (auto child : children) {
@@ -31,7 +49,8 @@ void InternalNode<Key>::remove_from_node(int index, int order) {
 
 template <typename Key>
 InternalNode<Key>* InternalNode<Key>::split(int order) {
-    InternalNode* new_node = new InternalNode();
+    InternalNode* new_node = create(order);
+    new_node->level = this->level;
     int split_index = this->size / 2;
     Key split_key = this->keys[split_index];
 
@@ -47,6 +66,14 @@ InternalNode<Key>* InternalNode<Key>::split(int order) {
         child->parent = new_node;
     }
 
+    // 先通过右链接发布新节点，分隔键稍后再安装到父节点
+    new_node->high_key = this->high_key;
+    new_node->has_high_key = this->has_high_key;
+    new_node->right = this->right;
+    this->high_key = split_key;
+    this->has_high_key = true;
+    this->right = new_node;
+
     return new_node;
 }
 
@@ -57,7 +84,7 @@ void InternalNode<Key>::borrow_from_left(int child_index, int order) {
     
     // 将左兄弟的最后一个键上移到父节点
     child->keys.insert(child->keys.begin(), this->keys[child_index - 1]);
-    this->keys[child_index - 1] = left_sibling->keys[left_sibling->size - 1];
+    this->keys.set(child_index - 1, left_sibling->keys[left_sibling->size - 1]);
     
     // 移动左兄弟的最后一个子节点
     if (!child->is_leaf) {
@@ -72,6 +99,7 @@ void InternalNode<Key>::borrow_from_left(int child_index, int order) {
     left_sibling->keys.pop_back();
     left_sibling->size--;
     child->size++;
+    left_sibling->high_key = this->keys[child_index - 1];
 }
 
 template <typename Key>
@@ -81,7 +109,7 @@ void InternalNode<Key>::borrow_from_right(int child_index, int order) {
     
     // 将右兄弟的第一个键上移到父节点
     child->keys.push_back(this->keys[child_index]);
-    this->keys[child_index] = right_sibling->keys[0];
+    this->keys.set(child_index, right_sibling->keys[0]);
     right_sibling->keys.erase(right_sibling->keys.begin());
     
     // 移动右兄弟的第一个子节点
@@ -95,6 +123,7 @@ void InternalNode<Key>::borrow_from_right(int child_index, int order) {
     
     right_sibling->size--;
     child->size++;
+    child->high_key = this->keys[child_index];
 }
 
 // 显式实例化
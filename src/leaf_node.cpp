@@ -1,15 +1,34 @@
 #include"leaf_node.h"
 
+// 内存布局：[LeafNode][keys: order+1][values: order+1]
 template <typename Key>
-LeafNode<Key>::LeafNode() : BaseNode<Key>(true), prev(nullptr), next(nullptr) {
-    this->values.reserve(1);
+std::size_t LeafNode<Key>::keys_offset() {
+    return node_align_up(sizeof(LeafNode), BaseNode<Key>::KeyArray::storage_alignment);
 }
 
+template <typename Key>
+std::size_t LeafNode<Key>::values_offset(int order) {
+    return node_align_up(keys_offset() + BaseNode<Key>::KeyArray::storage_bytes(order + 1), alignof(uint64_t));
+}
+
+template <typename Key>
+LeafNode<Key>* LeafNode<Key>::create(int order) {
+    NodeBlock block{values_offset(order) + sizeof(uint64_t) * (order + 1)};
+    return new (block) LeafNode(order);
+}
+
+template <typename Key>
+LeafNode<Key>::LeafNode(int order)
+    : BaseNode<Key>(true, order, reinterpret_cast<char*>(this) + keys_offset()),
+      values(reinterpret_cast<uint64_t*>(reinterpret_cast<char*>(this) + values_offset(order)), order + 1),
+      prev(nullptr), next(nullptr), dirty(true) {}
+
 template <typename Key>
 void LeafNode<Key>::insert_in_node(const Key& key, uint64_t value, 
                                   BaseNode<Key>* right_child, int order) {
+    dirty = true;
     int index = this->find_index(key);
-    if (index < this->size && this->keys[index] == key) {
+    if (index < this->size && this->keys.equals(index, key)) {
         values[index] = value;
         return;
     }
@@ -21,6 +40,7 @@ void LeafNode<Key>::insert_in_node(const Key& key, uint64_t value,
 
 template <typename Key>
 void LeafNode<Key>::remove_from_node(int index, int order) {
+    dirty = true;
     this->keys.erase(this->keys.begin() + index);
     values.erase(values.begin() + index);
     this->size--;
@@ -28,7 +48,8 @@ void LeafNode<Key>::remove_from_node(int index, int order) {
 
 template <typename Key>
 LeafNode<Key>* LeafNode<Key>::split(int order) {
-    LeafNode* new_node = new LeafNode();
+    LeafNode* new_node = create(order);
+    dirty = true;
     int split_index = (this->size + 1) / 2;
 
     new_node->keys.assign(this->keys.begin() + split_index, this->keys.end());
@@ -39,9 +60,15 @@ LeafNode<Key>* LeafNode<Key>::split(int order) {
     values.resize(split_index);
     this->size = split_index;
 
+    // next即B-link右链接，新节点先通过它对并发访问可见
+    new_node->high_key = this->high_key;
+    new_node->has_high_key = this->has_high_key;
+    this->high_key = new_node->keys[0];
+    this->has_high_key = true;
+
     new_node->next = this->next;
-    new_node->prev = this;
-    if (this->next) this->next->prev = new_node;
+    new_node->prev.store(this, std::memory_order_release);
+    if (this->next) this->next->prev.store(new_node, std::memory_order_release);
     this->next = new_node;
 
     return new_node;
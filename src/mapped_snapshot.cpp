@@ -0,0 +1,195 @@
+#include "mapped_snapshot.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+
+#include "b_plus_tree.h"
+
+template <typename Key>
+MappedSnapshot<Key>::MappedSnapshot(const std::string& path) : data(nullptr), length(0) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("Failed to open snapshot: " + path);
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(MappedSnapshotHeader)) {
+        ::close(fd);
+        throw std::runtime_error("Invalid snapshot: " + path);
+    }
+    length = st.st_size;
+    void* mapped = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) throw std::runtime_error("Failed to mmap snapshot: " + path);
+    data = static_cast<const char*>(mapped);
+
+    std::memcpy(&header, data, sizeof(header));
+    int32_t key_type = std::is_same<Key, int>::value ? 0 : 1;
+    if (header.magic != MAPPED_SNAPSHOT_MAGIC || header.file_size != length || header.root >= length ||
+        header.first_leaf >= length) {
+        unmap();
+        throw std::runtime_error("Invalid snapshot: " + path);
+    }
+    if (header.key_type != key_type) {
+        unmap();
+        throw std::runtime_error("Failed to open snapshot：Key Type Not Match");
+    }
+}
+
+template <typename Key>
+MappedSnapshot<Key>::~MappedSnapshot() {
+    unmap();
+}
+
+template <typename Key>
+void MappedSnapshot<Key>::unmap() {
+    if (data) ::munmap(const_cast<char*>(data), length);
+    data = nullptr;
+}
+
+template <typename Key>
+int MappedSnapshot<Key>::node_size(const char* node) {
+    return reinterpret_cast<const MappedNodeHeader*>(node)->size;
+}
+
+template <typename Key>
+auto MappedSnapshot<Key>::key_at(const char* node, int index) -> KeyView {
+    const char* slot = node + sizeof(MappedNodeHeader) + MappedNodeLayout<Key>::slot_size * index;
+    if constexpr (std::is_same<Key, int>::value) {
+        return *reinterpret_cast<const int32_t*>(slot);
+    } else {
+        const MappedStringSlot* s = reinterpret_cast<const MappedStringSlot*>(slot);
+        return std::string_view(node + s->offset, s->length);
+    }
+}
+
+template <typename Key>
+uint64_t MappedSnapshot<Key>::array_at(const char* node, int index) {
+    return reinterpret_cast<const uint64_t*>(node + MappedNodeLayout<Key>::array_offset(node_size(node)))[index];
+}
+
+template <typename Key>
+int MappedSnapshot<Key>::lower_bound(const char* node, KeyView key) {
+    int lo = 0, hi = node_size(node);
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (key_at(node, mid) < key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+template <typename Key>
+int MappedSnapshot<Key>::upper_bound(const char* node, KeyView key) {
+    int lo = 0, hi = node_size(node);
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (key < key_at(node, mid))
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    return lo;
+}
+
+// 内部节点第i个子节点包含[keys[i-1], keys[i])内的键
+template <typename Key>
+const char* MappedSnapshot<Key>::find_leaf(KeyView key) const {
+    if (header.root == 0) return nullptr;
+    const char* current = node(header.root);
+    while (!reinterpret_cast<const MappedNodeHeader*>(current)->is_leaf) {
+        current = node(array_at(current, upper_bound(current, key)));
+    }
+    return current;
+}
+
+template <typename Key>
+uint64_t MappedSnapshot<Key>::find(const Key& key) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    if (tree) return tree->find(key);
+
+    const char* leaf = find_leaf(key);
+    if (!leaf) return 0;
+    int index = lower_bound(leaf, key);
+    if (index < node_size(leaf) && key_at(leaf, index) == KeyView(key)) return array_at(leaf, index);
+    return 0;
+}
+
+template <typename Key>
+std::vector<std::pair<Key, uint64_t>> MappedSnapshot<Key>::range_find(const Key& start, const Key& end) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    if (tree) return tree->range_find(start, end);
+
+    std::vector<std::pair<Key, uint64_t>> results;
+    const char* leaf = find_leaf(start);
+    if (!leaf) return results;
+    KeyView end_view(end);
+    int index = lower_bound(leaf, start);
+    while (true) {
+        for (; index < node_size(leaf); index++) {
+            KeyView key = key_at(leaf, index);
+            if (end_view < key) return results;
+            results.emplace_back(Key(key), array_at(leaf, index));
+        }
+        uint64_t next = reinterpret_cast<const MappedNodeHeader*>(leaf)->next;
+        if (next == 0) return results;
+        leaf = node(next);
+        index = 0;
+    }
+}
+
+template <typename Key>
+size_t MappedSnapshot<Key>::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    if (tree) return tree->size();
+    return header.entry_count;
+}
+
+// 沿叶子链顺序读出全部条目并批量构建
+template <typename Key>
+BPlusTree<Key, 0>* MappedSnapshot<Key>::writable() {
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        if (tree) return tree.get();
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (tree) return tree.get();
+
+    std::vector<std::pair<Key, uint64_t>> items;
+    items.reserve(header.entry_count);
+    for (uint64_t offset = header.first_leaf; offset != 0;) {
+        const char* leaf = node(offset);
+        for (int i = 0; i < node_size(leaf); i++) items.emplace_back(Key(key_at(leaf, i)), array_at(leaf, i));
+        offset = reinterpret_cast<const MappedNodeHeader*>(leaf)->next;
+    }
+    auto materialized_tree = std::make_unique<BPlusTree<Key, 0>>(header.order);
+    materialized_tree->bulk_load(items.begin(), items.end());
+    tree = std::move(materialized_tree);
+    unmap();
+    return tree.get();
+}
+
+template <typename Key>
+void MappedSnapshot<Key>::insert(const Key& key, uint64_t value) {
+    // 树一旦建立就不再替换，取得指针后无需持锁
+    writable()->insert(key, value);
+}
+
+template <typename Key>
+void MappedSnapshot<Key>::remove(const Key& key) {
+    writable()->remove(key);
+}
+
+template <typename Key>
+bool MappedSnapshot<Key>::materialized() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return tree != nullptr;
+}
+
+template class MappedSnapshot<int>;
+template class MappedSnapshot<std::string>;
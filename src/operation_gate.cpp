@@ -0,0 +1,45 @@
+#include "operation_gate.h"
+
+#include <thread>
+
+OperationGate::OperationGate() : closed(false) {
+    for (auto& slot : slots) {
+        slot.active.store(0, std::memory_order_relaxed);
+    }
+}
+
+void OperationGate::lock_shared() {
+    while (true) {
+        Slot& slot = slots[acquire_thread_slot()];
+        // 已在闸门内（嵌套调用）时直接进入，独占方会等待外层操作退出
+        if (slot.active.fetch_add(1, std::memory_order_seq_cst) > 0) return;
+        if (!closed.load(std::memory_order_seq_cst)) return;
+
+        // 闸门关闭：撤回计数并交出槽位（溢出槽位可能正被独占方需要），等独占操作结束后重试
+        slot.active.fetch_sub(1, std::memory_order_release);
+        release_thread_slot();
+        while (closed.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void OperationGate::unlock_shared() {
+    slots[current_thread_slot()].active.fetch_sub(1, std::memory_order_release);
+    release_thread_slot();
+}
+
+void OperationGate::lock() {
+    exclusive_mutex.lock();
+    closed.store(true, std::memory_order_seq_cst);
+    for (auto& slot : slots) {
+        while (slot.active.load(std::memory_order_seq_cst) != 0) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void OperationGate::unlock() {
+    closed.store(false, std::memory_order_release);
+    exclusive_mutex.unlock();
+}
@@ -0,0 +1,109 @@
+#include "page_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+constexpr uint64_t PAGE_FILE_MAGIC = 0x3145474150505442ULL;  // "BTPPAGE1"
+constexpr uint64_t INITIAL_CAPACITY = 16;
+
+}  // namespace
+
+PageFile::PageFile(const std::string& path) : fd(-1), data(nullptr), capacity(0) {
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) throw std::runtime_error("Failed to open page file: " + path);
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Failed to stat page file: " + path);
+    }
+
+    if (st.st_size == 0) {
+        // 新文件：写入文件头
+        try {
+            map(INITIAL_CAPACITY);
+        } catch (...) {
+            ::close(fd);
+            throw;
+        }
+        Header* h = header();
+        h->magic = PAGE_FILE_MAGIC;
+        h->page_size = page_size;
+        h->page_count = 1;
+        return;
+    }
+
+    if (st.st_size % page_size != 0) {
+        ::close(fd);
+        throw std::runtime_error("Corrupted page file: size is not a multiple of page size");
+    }
+    try {
+        map(st.st_size / page_size);
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    Header* h = header();
+    if (h->magic != PAGE_FILE_MAGIC || h->page_size != page_size || h->page_count == 0 ||
+        h->page_count > capacity) {
+        ::munmap(data, capacity * page_size);
+        ::close(fd);
+        throw std::runtime_error("Invalid page file header: " + path);
+    }
+}
+
+PageFile::~PageFile() {
+    if (data) ::munmap(data, capacity * page_size);
+    if (fd >= 0) ::close(fd);
+}
+
+PageFile::Header* PageFile::header() const { return reinterpret_cast<Header*>(data); }
+
+void PageFile::map(uint64_t new_capacity) {
+    if (::ftruncate(fd, new_capacity * page_size) != 0) throw std::runtime_error("Failed to extend page file");
+    void* mapped = ::mmap(nullptr, new_capacity * page_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) throw std::runtime_error("Failed to mmap page file");
+    if (data) ::munmap(data, capacity * page_size);
+    data = static_cast<char*>(mapped);
+    capacity = new_capacity;
+}
+
+char* PageFile::page(uint64_t id) const {
+    if (id >= header()->page_count) throw std::runtime_error("Page id out of range");
+    return data + id * page_size;
+}
+
+uint64_t PageFile::allocate() {
+    uint64_t id = header()->page_count;
+    if (id == capacity) map(capacity * 2);  // 成倍扩展，减少重新映射次数
+    header()->page_count = id + 1;
+    std::memset(page(id), 0, page_size);
+    return id;
+}
+
+uint64_t PageFile::page_count() const { return header()->page_count; }
+
+void PageFile::read_page(uint64_t id, char* buffer) const {
+    if (id >= header()->page_count) throw std::runtime_error("Page id out of range");
+    if (::pread(fd, buffer, page_size, static_cast<off_t>(id * page_size)) != page_size)
+        throw std::runtime_error("Failed to read page");
+}
+
+void PageFile::write_page(uint64_t id, const char* buffer) {
+    if (id >= header()->page_count) throw std::runtime_error("Page id out of range");
+    if (::pwrite(fd, buffer, page_size, static_cast<off_t>(id * page_size)) != page_size)
+        throw std::runtime_error("Failed to write page");
+}
+
+char* PageFile::user_meta() const { return data + 64; }
+
+void PageFile::sync() {
+    if (::msync(data, capacity * page_size, MS_SYNC) != 0) throw std::runtime_error("Failed to sync page file");
+}
@@ -0,0 +1,36 @@
+#include "range_cursor.h"
+
+#include "b_plus_tree.h"
+
+template <typename Key, int Order>
+RangeCursor<Key, Order>::RangeCursor(const BPlusTree<Key, Order>* tree, const Key& start, bool reverse)
+    : tree(tree), reverse(reverse), position(0) {
+    if (reverse) {
+        tree->scan_batch_reverse(start, true, batch);
+    } else {
+        tree->scan_batch(start, true, batch);
+    }
+}
+
+template <typename Key, int Order>
+void RangeCursor<Key, Order>::next() {
+    if (!valid() || ++position < batch.size()) return;
+    // 当前批已读完，从最后一个键之后取下一批
+    Key last = batch.back().first;
+    position = 0;
+    if (reverse) {
+        tree->scan_batch_reverse(last, false, batch);
+    } else {
+        tree->scan_batch(last, false, batch);
+    }
+}
+
+// 显式实例化，与BPlusTree的实例化保持一致
+template class RangeCursor<int>;
+template class RangeCursor<std::string>;
+template class RangeCursor<int, 16>;
+template class RangeCursor<int, 64>;
+template class RangeCursor<int, 128>;
+template class RangeCursor<int, 256>;
+template class RangeCursor<std::string, 16>;
+template class RangeCursor<std::string, 64>;
@@ -0,0 +1,126 @@
+#include "simd_search.h"
+
+#include <algorithm>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_SEARCH_X86 1
+#include <immintrin.h>
+#endif
+
+// 无分支二分，直到剩余区间不超过window，答案位于[lo, lo + n]
+template <typename T>
+static inline void narrow_range(const T* keys, int size, T key, int window, int& lo, int& n) {
+    lo = 0;
+    n = size;
+    while (n > window) {
+        int half = n / 2;
+        lo = keys[lo + half - 1] < key ? lo + half : lo;
+        n -= half;
+    }
+}
+
+template <typename T>
+static int lower_bound_scalar(const T* keys, int size, T key) {
+    return std::lower_bound(keys, keys + size, key) - keys;
+}
+
+#ifdef SIMD_SEARCH_X86
+
+__attribute__((target("avx2"))) static int lower_bound_avx2(const int32_t* keys, int size, int32_t key) {
+    int lo, n;
+    narrow_range(keys, size, key, 32, lo, n);
+    const int32_t* base = keys + lo;
+    __m256i needle = _mm256_set1_epi32(key);
+    int count = 0, i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(base + i));
+        __m256i less = _mm256_cmpgt_epi32(needle, block);
+        count += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(less)));
+    }
+    for (; i < n; i++) count += base[i] < key;
+    return lo + count;
+}
+
+__attribute__((target("sse2"))) static int lower_bound_sse(const int32_t* keys, int size, int32_t key) {
+    int lo, n;
+    narrow_range(keys, size, key, 16, lo, n);
+    const int32_t* base = keys + lo;
+    __m128i needle = _mm_set1_epi32(key);
+    int count = 0, i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(base + i));
+        __m128i less = _mm_cmpgt_epi32(needle, block);
+        count += __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(less)));
+    }
+    for (; i < n; i++) count += base[i] < key;
+    return lo + count;
+}
+
+__attribute__((target("avx2"))) static int lower_bound_avx2(const int64_t* keys, int size, int64_t key) {
+    int lo, n;
+    narrow_range(keys, size, key, 16, lo, n);
+    const int64_t* base = keys + lo;
+    __m256i needle = _mm256_set1_epi64x(key);
+    int count = 0, i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(base + i));
+        __m256i less = _mm256_cmpgt_epi64(needle, block);
+        count += __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(less)));
+    }
+    for (; i < n; i++) count += base[i] < key;
+    return lo + count;
+}
+
+__attribute__((target("sse4.2"))) static int lower_bound_sse(const int64_t* keys, int size, int64_t key) {
+    int lo, n;
+    narrow_range(keys, size, key, 8, lo, n);
+    const int64_t* base = keys + lo;
+    __m128i needle = _mm_set1_epi64x(key);
+    int count = 0, i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(base + i));
+        __m128i less = _mm_cmpgt_epi64(needle, block);
+        count += __builtin_popcount(_mm_movemask_pd(_mm_castsi128_pd(less)));
+    }
+    for (; i < n; i++) count += base[i] < key;
+    return lo + count;
+}
+
+#endif
+
+using Search32 = int (*)(const int32_t*, int, int32_t);
+using Search64 = int (*)(const int64_t*, int, int64_t);
+
+static Search32 select_search32() {
+#ifdef SIMD_SEARCH_X86
+    if (__builtin_cpu_supports("avx2")) return lower_bound_avx2;
+    if (__builtin_cpu_supports("sse2")) return lower_bound_sse;
+#endif
+    return lower_bound_scalar<int32_t>;
+}
+
+static Search64 select_search64() {
+#ifdef SIMD_SEARCH_X86
+    if (__builtin_cpu_supports("avx2")) return lower_bound_avx2;
+    if (__builtin_cpu_supports("sse4.2")) return lower_bound_sse;
+#endif
+    return lower_bound_scalar<int64_t>;
+}
+
+int simd_lower_bound(const int32_t* keys, int size, int32_t key) {
+    static const Search32 search = select_search32();
+    return search(keys, size, key);
+}
+
+int simd_lower_bound(const int64_t* keys, int size, int64_t key) {
+    static const Search64 search = select_search64();
+    return search(keys, size, key);
+}
+
+const char* simd_search_variant() {
+#ifdef SIMD_SEARCH_X86
+    if (__builtin_cpu_supports("avx2")) return "avx2";
+    if (__builtin_cpu_supports("sse2")) return "sse";
+#endif
+    return "scalar";
+}
@@ -0,0 +1,203 @@
+#include "string_key_array.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <string_view>
+#include <vector>
+
+#include "simd_search.h"
+
+static const int head_bytes = 8;
+
+// 两个字符串在前limit个字节内的公共前缀长度
+static std::size_t common_prefix(const std::string& a, const std::string& b, std::size_t limit) {
+    std::size_t n = std::min(limit, std::min(a.size(), b.size()));
+    std::size_t i = 0;
+    while (i < n && a[i] == b[i]) i++;
+    return i;
+}
+
+std::size_t StringKeyArray::storage_bytes(int capacity) {
+    return sizeof(int64_t) * capacity + sizeof(uint32_t) * capacity;
+}
+
+StringKeyArray::StringKeyArray(void* storage, int capacity)
+    : heads(static_cast<int64_t*>(storage)),
+      ends(reinterpret_cast<uint32_t*>(static_cast<char*>(storage) + sizeof(int64_t) * capacity)),
+      count(0),
+      cap(capacity) {}
+
+int64_t StringKeyArray::head_of(const char* suffix, std::size_t length) {
+    uint64_t head = 0;
+    std::size_t available = std::min<std::size_t>(head_bytes, length);
+    for (std::size_t i = 0; i < head_bytes; i++) {
+        head <<= 8;
+        if (i < available) head |= static_cast<unsigned char>(suffix[i]);
+    }
+    return static_cast<int64_t>(head ^ (uint64_t(1) << 63));
+}
+
+std::string StringKeyArray::operator[](int index) const {
+    std::string key;
+    key.reserve(prefix.size() + suffix_length(index));
+    key.append(prefix);
+    key.append(suffixes, suffix_begin(index), suffix_length(index));
+    return key;
+}
+
+bool StringKeyArray::equals(int index, const std::string& key) const {
+    uint32_t length = suffix_length(index);
+    return key.size() == prefix.size() + length && key.compare(0, prefix.size(), prefix) == 0 &&
+           key.compare(prefix.size(), length, suffixes, suffix_begin(index), length) == 0;
+}
+
+// 缩短公共前缀：被移出前缀的字节补到每个后缀前面，并重算键头
+void StringKeyArray::shrink_prefix(std::size_t length) {
+    std::string moved = prefix.substr(length);
+    std::string rebuilt;
+    rebuilt.reserve(suffixes.size() + moved.size() * count);
+    uint32_t begin = 0;
+    for (int i = 0; i < count; i++) {
+        rebuilt.append(moved);
+        rebuilt.append(suffixes, begin, ends[i] - begin);
+        begin = ends[i];
+        ends[i] = static_cast<uint32_t>(rebuilt.size());
+    }
+    suffixes.swap(rebuilt);
+    prefix.resize(length);
+    for (int i = 0; i < count; i++) heads[i] = head_of(suffixes.data() + suffix_begin(i), suffix_length(i));
+}
+
+// 由有序的完整键重新计算公共前缀并重建后缀区
+void StringKeyArray::rebuild(const std::string* keys, int n) {
+    if (n > cap) throw std::runtime_error("Node capacity exceeded");
+    prefix.clear();
+    suffixes.clear();
+    count = n;
+    if (n == 0) return;
+
+    std::size_t length = keys[0].size();
+    for (int i = 1; i < n && length > 0; i++) length = common_prefix(keys[0], keys[i], length);
+    prefix.assign(keys[0], 0, length);
+    for (int i = 0; i < n; i++) {
+        suffixes.append(keys[i], length, std::string::npos);
+        ends[i] = static_cast<uint32_t>(suffixes.size());
+        heads[i] = head_of(keys[i].data() + length, keys[i].size() - length);
+    }
+}
+
+void StringKeyArray::set(int index, const std::string& value) {
+    erase(begin() + index);
+    insert(begin() + index, value);
+}
+
+void StringKeyArray::push_back(const std::string& value) {
+    insert(end(), value);
+}
+
+void StringKeyArray::pop_back() {
+    erase(end() - 1);
+}
+
+StringKeyArray::const_iterator StringKeyArray::insert(const_iterator pos, const std::string& value) {
+    if (count + 1 > cap) throw std::runtime_error("Node capacity exceeded");
+    int index = pos.index;
+    if (count == 0) {
+        prefix = value;
+    } else {
+        std::size_t shared = common_prefix(value, prefix, prefix.size());
+        if (shared < prefix.size()) shrink_prefix(shared);
+    }
+
+    uint32_t offset = suffix_begin(index);
+    uint32_t length = static_cast<uint32_t>(value.size() - prefix.size());
+    suffixes.insert(offset, value, prefix.size(), length);
+    std::memmove(heads + index + 1, heads + index, sizeof(int64_t) * (count - index));
+    std::memmove(ends + index + 1, ends + index, sizeof(uint32_t) * (count - index));
+    count++;
+    for (int i = index + 1; i < count; i++) ends[i] += length;
+    ends[index] = offset + length;
+    heads[index] = head_of(value.data() + prefix.size(), length);
+    return begin() + index;
+}
+
+// 区间插入只在分裂合并时使用，直接按完整键重建
+StringKeyArray::const_iterator StringKeyArray::insert(const_iterator pos, const_iterator first,
+                                                      const_iterator last) {
+    int index = pos.index;
+    std::vector<std::string> keys;
+    keys.reserve(count + (last - first));
+    for (int i = 0; i < index; i++) keys.push_back((*this)[i]);
+    for (; first != last; ++first) keys.push_back(*first);
+    for (int i = index; i < count; i++) keys.push_back((*this)[i]);
+    rebuild(keys.data(), keys.size());
+    return begin() + index;
+}
+
+StringKeyArray::const_iterator StringKeyArray::erase(const_iterator pos) {
+    return erase(pos, pos + 1);
+}
+
+StringKeyArray::const_iterator StringKeyArray::erase(const_iterator first, const_iterator last) {
+    int index = first.index;
+    int removed = last - first;
+    if (removed == 0) return first;
+    uint32_t offset = suffix_begin(index);
+    uint32_t length = ends[index + removed - 1] - offset;
+    suffixes.erase(offset, length);
+    std::memmove(heads + index, heads + index + removed, sizeof(int64_t) * (count - index - removed));
+    std::memmove(ends + index, ends + index + removed, sizeof(uint32_t) * (count - index - removed));
+    count -= removed;
+    for (int i = index; i < count; i++) ends[i] -= length;
+    // 删除不会破坏公共前缀，保留较短的前缀即可
+    if (count == 0) prefix.clear();
+    return begin() + index;
+}
+
+void StringKeyArray::assign(const_iterator first, const_iterator last) {
+    std::vector<std::string> keys;
+    keys.reserve(last - first);
+    for (; first != last; ++first) keys.push_back(*first);
+    rebuild(keys.data(), keys.size());
+}
+
+void StringKeyArray::resize(int new_count) {
+    if (new_count < count) {
+        erase(begin() + new_count, end());
+    } else {
+        while (count < new_count) push_back(std::string());
+    }
+}
+
+void StringKeyArray::clear() {
+    prefix.clear();
+    suffixes.clear();
+    count = 0;
+}
+
+int StringKeyArray::lower_bound(const std::string& key) const {
+    if (count == 0) return 0;
+
+    // 不带公共前缀的键整体小于或大于节点内所有键
+    int cmp = key.compare(0, prefix.size(), prefix);
+    if (cmp < 0) return 0;
+    if (cmp > 0) return count;
+
+    std::string_view rest = std::string_view(key).substr(prefix.size());
+    int64_t head = head_of(rest.data(), rest.size());
+    int lo = simd_lower_bound(heads, count, head);
+    int hi = head == std::numeric_limits<int64_t>::max() ? count : simd_lower_bound(heads, count, head + 1);
+
+    // 键头相同的区间内比较完整后缀
+    std::string_view all(suffixes);
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (all.substr(suffix_begin(mid), suffix_length(mid)) < rest) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
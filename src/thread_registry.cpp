@@ -0,0 +1,58 @@
+#include "thread_registry.h"
+
+#include <atomic>
+#include <mutex>
+
+namespace {
+
+std::atomic<bool> slot_used[MAX_THREAD_SLOTS];
+
+// 溢出槽位的持有者互斥
+std::mutex overflow_mutex;
+
+// 线程局部持有者，析构时（线程退出）归还槽位
+struct SlotHolder {
+    int slot = -1;
+    int overflow_depth = 0;  // 使用溢出槽位时的嵌套深度
+
+    ~SlotHolder() {
+        if (slot >= 0) slot_used[slot].store(false, std::memory_order_release);
+    }
+};
+
+thread_local SlotHolder holder;
+
+int claim_free_slot() {
+    for (int i = 0; i < MAX_THREAD_SLOTS; i++) {
+        if (!slot_used[i].load(std::memory_order_relaxed) && !slot_used[i].exchange(true, std::memory_order_acquire)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+}  // namespace
+
+int acquire_thread_slot() {
+    if (holder.slot >= 0) return holder.slot;
+    if (holder.overflow_depth++ > 0) return OVERFLOW_THREAD_SLOT;
+
+    // 不在操作中时才尝试领取独占槽位，保证同一操作内槽位不变
+    int slot = claim_free_slot();
+    if (slot >= 0) {
+        holder.slot = slot;
+        holder.overflow_depth = 0;
+        return slot;
+    }
+    overflow_mutex.lock();
+    return OVERFLOW_THREAD_SLOT;
+}
+
+void release_thread_slot() {
+    if (holder.slot >= 0) return;
+    if (--holder.overflow_depth == 0) overflow_mutex.unlock();
+}
+
+int current_thread_slot() {
+    return holder.slot >= 0 ? holder.slot : OVERFLOW_THREAD_SLOT;
+}
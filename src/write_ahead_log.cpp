@@ -0,0 +1,208 @@
+#include "write_ahead_log.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+uint32_t crc32(const char* data, std::size_t size) {
+    static const std::vector<uint32_t> table = [] {
+        std::vector<uint32_t> t(256);
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+    uint32_t crc = 0xFFFFFFFFu;
+    for (std::size_t i = 0; i < size; i++) crc = table[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
+}
+
+void write_all(int fd, const char* data, std::size_t size) {
+    while (size > 0) {
+        ssize_t n = ::write(fd, data, size);
+        if (n < 0) throw std::runtime_error("Failed to write log");
+        data += n;
+        size -= n;
+    }
+}
+
+}  // namespace
+
+WriteAheadLog::WriteAheadLog(const std::string& path, const WalOptions& options)
+    : options(options), appended_lsn(0), durable_lsn(0), writing(false) {
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) throw std::runtime_error("Failed to open log file: " + path);
+    // 文件可能是新建的，目录项落盘后提交到其中的记录才不会在崩溃后连同文件一起丢失
+    try {
+        sync_directory(path);
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+}
+
+WriteAheadLog::~WriteAheadLog() {
+    try {
+        flush();
+    } catch (const std::exception&) {
+        // 析构中无法上报写出失败
+    }
+    ::close(fd);
+}
+
+uint64_t WriteAheadLog::append(const char* data, std::size_t size) {
+    uint32_t length = static_cast<uint32_t>(size);
+    uint32_t checksum = crc32(data, size);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    if (error) std::rethrow_exception(error);
+    buffer.append(reinterpret_cast<const char*>(&length), sizeof(length));
+    buffer.append(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+    buffer.append(data, size);
+    uint64_t lsn = ++appended_lsn;
+
+    if (options.sync_commit) {
+        // 唤醒正在等待搭车记录的领导者
+        if (appended_lsn - durable_lsn >= options.group_commit_size) cv.notify_all();
+    } else if (buffer.size() >= options.buffer_size && !writing) {
+        write_out(lock, false);
+    }
+    return lsn;
+}
+
+void WriteAheadLog::wait_durable(uint64_t lsn) {
+    if (!options.sync_commit) return;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    bool waited = false;
+    while (durable_lsn < lsn) {
+        if (error) std::rethrow_exception(error);
+        if (writing) {
+            cv.wait(lock);
+            continue;
+        }
+        // 成为领导者：可选地等待更多记录到达，再把整个缓冲一次写出
+        if (!waited && options.group_commit_delay.count() > 0 &&
+            appended_lsn - durable_lsn < options.group_commit_size) {
+            waited = true;
+            cv.wait_for(lock, options.group_commit_delay, [&] {
+                return writing || durable_lsn >= lsn || appended_lsn - durable_lsn >= options.group_commit_size;
+            });
+            continue;
+        }
+        write_out(lock, true);
+    }
+}
+
+// 调用时持有lock且没有其他领导者；写文件期间释放锁，新记录追加到新的缓冲中。
+// 失败时文件尾部可能已有不完整的记录，不再写入，错误保留给之后的所有调用方
+void WriteAheadLog::write_out(std::unique_lock<std::mutex>& lock, bool sync) {
+    if (error) std::rethrow_exception(error);
+    writing = true;
+    std::string data;
+    data.swap(buffer);
+    uint64_t upto = appended_lsn;
+    lock.unlock();
+
+    try {
+        write_all(fd, data.data(), data.size());
+        if (sync && ::fdatasync(fd) != 0) throw std::runtime_error("Failed to sync log");
+    } catch (...) {
+        lock.lock();
+        writing = false;
+        error = std::current_exception();
+        cv.notify_all();
+        throw;
+    }
+
+    lock.lock();
+    writing = false;
+    durable_lsn = upto;
+    cv.notify_all();
+}
+
+void WriteAheadLog::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [&] { return !writing; });
+    write_out(lock, true);
+}
+
+void WriteAheadLog::rotate(const std::string& new_path) {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [&] { return !writing; });
+    if (error) std::rethrow_exception(error);
+    int new_fd = ::open(new_path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (new_fd < 0) throw std::runtime_error("Failed to open log file: " + new_path);
+    try {
+        sync_directory(new_path);
+    } catch (...) {
+        ::close(new_fd);
+        throw;
+    }
+
+    // 持有锁写出，保证切换前追加的记录都落在旧文件中
+    try {
+        write_all(fd, buffer.data(), buffer.size());
+        if (::fdatasync(fd) != 0) throw std::runtime_error("Failed to sync log");
+    } catch (...) {
+        ::close(new_fd);
+        error = std::current_exception();
+        cv.notify_all();
+        throw;
+    }
+    buffer.clear();
+    durable_lsn = appended_lsn;
+    ::close(fd);
+    fd = new_fd;
+    cv.notify_all();
+}
+
+void WriteAheadLog::replay(const std::string& path, const std::function<void(const char*, std::size_t)>& apply) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return;
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    std::size_t pos = 0;
+    while (data.size() - pos >= 2 * sizeof(uint32_t)) {
+        uint32_t length, checksum;
+        std::memcpy(&length, data.data() + pos, sizeof(length));
+        std::memcpy(&checksum, data.data() + pos + sizeof(length), sizeof(checksum));
+        const char* record = data.data() + pos + 2 * sizeof(uint32_t);
+        if (data.size() - pos - 2 * sizeof(uint32_t) < length || crc32(record, length) != checksum) break;
+        apply(record, length);
+        pos += 2 * sizeof(uint32_t) + length;
+    }
+
+    // 截掉无效的尾部，否则之后追加的记录会排在其后而无法回放
+    if (pos < data.size() && ::truncate(path.c_str(), static_cast<off_t>(pos)) != 0) {
+        throw std::runtime_error("Failed to truncate log: " + path);
+    }
+}
+
+void WriteAheadLog::sync_file(const std::string& path) {
+    int file_fd = ::open(path.c_str(), O_RDONLY);
+    if (file_fd < 0) throw std::runtime_error("Failed to open file for sync: " + path);
+    int result = ::fsync(file_fd);
+    ::close(file_fd);
+    if (result != 0) throw std::runtime_error("Failed to sync file: " + path);
+}
+
+void WriteAheadLog::sync_directory(const std::string& path) {
+    std::string directory = std::filesystem::path(path).parent_path().string();
+    if (directory.empty()) directory = ".";
+    int dir_fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if (dir_fd < 0) throw std::runtime_error("Failed to open directory for sync: " + directory);
+    int result = ::fsync(dir_fd);
+    ::close(dir_fd);
+    if (result != 0) throw std::runtime_error("Failed to sync directory: " + directory);
+}
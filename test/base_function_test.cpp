@@ -1,10 +1,15 @@
 #include <atomic>
+#include <filesystem>
 #include <gtest/gtest.h>
+#include <map>
 #include <random>
 #include <set>
 #include <thread>
 
 #include "../include/b_plus_tree.h"
+#include "../include/disk_b_plus_tree.h"
+#include "../include/mapped_snapshot.h"
+#include "../include/simd_search.h"
 
 // 测试基本插入和查找
 TEST(BPlusTreeTest, InsertAndFind) {
@@ -114,6 +119,632 @@ TEST(BPlusTreeTest, TreeStructure) {
     }
 }
 
+// 测试分页范围查询：limit提前停止，开区间边界
+TEST(BPlusTreeTest, RangeFindWithLimit) {
+    BPlusTree<int> tree(4);
+    for (int i = 0; i < 1000; i++) tree.insert(i * 2, i);
+
+    RangeOptions first_page;
+    first_page.limit = 100;
+    auto page = tree.range_find(501, first_page);
+    ASSERT_EQ(page.size(), 100);
+    EXPECT_EQ(page.front().first, 502);
+    EXPECT_EQ(page.back().first, 700);
+
+    RangeOptions next_page;
+    next_page.limit = 100;
+    next_page.start_inclusive = false;
+    page = tree.range_find(page.back().first, next_page);
+    ASSERT_EQ(page.size(), 100);
+    EXPECT_EQ(page.front().first, 702);
+
+    RangeOptions open_range;
+    open_range.start_inclusive = false;
+    open_range.end_inclusive = false;
+    auto results = tree.range_find(10, 20, open_range);
+    ASSERT_EQ(results.size(), 4);
+    EXPECT_EQ(results.front().first, 12);
+    EXPECT_EQ(results.back().first, 18);
+
+    EXPECT_EQ(tree.range_find(1990, first_page).size(), 5);
+    EXPECT_EQ(tree.range_find(10, 20).size(), 6);
+}
+
+// 测试范围聚合：计数模式与普通模式在随机增删后结果一致
+TEST(BPlusTreeTest, RangeAggregates) {
+    BPlusTree<int> counted_tree(4, true);
+    BPlusTree<int> plain_tree(4);
+    std::map<int, uint64_t> reference;
+    std::mt19937 rng(5);
+    for (int i = 0; i < 20000; i++) {
+        int key = rng() % 3000;
+        if (rng() % 3 == 0) {
+            counted_tree.remove(key);
+            plain_tree.remove(key);
+            reference.erase(key);
+        } else {
+            counted_tree.insert(key, key + 1);
+            plain_tree.insert(key, key + 1);
+            reference[key] = key + 1;
+        }
+    }
+    std::vector<std::pair<int, uint64_t>> batch;
+    for (int key = 3000; key < 3500; key++) batch.emplace_back(key, key + 1), reference[key] = key + 1;
+    counted_tree.insert_batch(batch);
+    plain_tree.insert_batch(batch);
+
+    for (int round = 0; round < 200; round++) {
+        int start = rng() % 3600, end = start + rng() % 800;
+        size_t expected_count = 0;
+        uint64_t expected_sum = 0;
+        for (auto it = reference.lower_bound(start); it != reference.end() && it->first <= end; ++it) {
+            expected_count++;
+            expected_sum += it->second;
+        }
+        ASSERT_EQ(counted_tree.range_count(start, end), expected_count);
+        ASSERT_EQ(plain_tree.range_count(start, end), expected_count);
+        ASSERT_EQ(plain_tree.range_sum(start, end), expected_sum);
+    }
+
+    RangeAggregate aggregate = plain_tree.range_aggregate(3000, 3499);
+    EXPECT_EQ(aggregate.count, 500);
+    EXPECT_EQ(aggregate.min, 3001);
+    EXPECT_EQ(aggregate.max, 3500);
+    EXPECT_EQ(counted_tree.range_count(10, 5), 0);
+
+    int visited = 0;
+    plain_tree.range_visit(3000, 3499, [&](const int&, uint64_t) { return ++visited < 10; });
+    EXPECT_EQ(visited, 10);
+
+    // 批量构建后计数同样可用
+    std::vector<std::pair<int, uint64_t>> items(reference.begin(), reference.end());
+    BPlusTree<int> loaded(8, true);
+    loaded.bulk_load(items.begin(), items.end());
+    EXPECT_EQ(loaded.range_count(0, 5000), reference.size());
+}
+
+// 测试顺序统计：rank与select互逆，计数模式与沿叶子链计数结果一致
+TEST(BPlusTreeTest, RankAndSelect) {
+    BPlusTree<int> counted_tree(4, true);
+    BPlusTree<int> plain_tree(4);
+    std::set<int> reference;
+    std::mt19937 rng(9);
+    for (int i = 0; i < 10000; i++) {
+        int key = rng() % 4000;
+        if (rng() % 3 == 0) {
+            counted_tree.remove(key);
+            plain_tree.remove(key);
+            reference.erase(key);
+        } else {
+            counted_tree.insert(key, key);
+            plain_tree.insert(key, key);
+            reference.insert(key);
+        }
+    }
+
+    ASSERT_EQ(counted_tree.size(), reference.size());
+    ASSERT_EQ(plain_tree.size(), reference.size());
+    std::vector<int> sorted(reference.begin(), reference.end());
+    for (size_t k = 0; k < sorted.size(); k += 7) {
+        ASSERT_EQ(counted_tree.select(k).first, sorted[k]);
+        ASSERT_EQ(plain_tree.select(k).first, sorted[k]);
+        ASSERT_EQ(counted_tree.rank(sorted[k]), k);
+        ASSERT_EQ(plain_tree.rank(sorted[k]), k);
+    }
+    EXPECT_EQ(counted_tree.rank(5000), sorted.size());
+    EXPECT_EQ(counted_tree.rank(-1), 0);
+    EXPECT_THROW(counted_tree.select(sorted.size()), std::runtime_error);
+    EXPECT_THROW(plain_tree.select(sorted.size()), std::runtime_error);
+}
+
+// 测试节点内存布局：节点与定长数组位于同一块缓存行对齐的内存中
+TEST(BPlusTreeTest, NodeLayoutContiguous) {
+    LeafNode<int>* leaf = LeafNode<int>::create(8);
+    char* base = reinterpret_cast<char*>(leaf);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(base) % 64, 0);
+    EXPECT_EQ(leaf->keys.capacity(), 9);
+    EXPECT_GE(reinterpret_cast<char*>(leaf->keys.begin()), base + sizeof(LeafNode<int>));
+    EXPECT_GE(reinterpret_cast<char*>(leaf->values.begin()), reinterpret_cast<char*>(leaf->keys.begin() + 9));
+
+    for (int i = 0; i < 9; i++) leaf->insert_in_node(i, i * 10, nullptr, 8);
+    EXPECT_EQ(leaf->values[8], 80);
+    EXPECT_THROW(leaf->insert_in_node(9, 90, nullptr, 8), std::runtime_error);
+    delete leaf;
+}
+
+// 测试编译期阶数：行为与运行时阶数一致，阶数不匹配时报错
+TEST(BPlusTreeTest, CompileTimeOrder) {
+    BPlusTree<int, 16> tree;
+    BPlusTree<int> reference(16);
+    std::mt19937 rng(7);
+    for (int i = 0; i < 20000; i++) {
+        int key = rng() % 5000;
+        if (rng() % 3 == 0) {
+            tree.remove(key);
+            reference.remove(key);
+        } else {
+            tree.insert(key, key + 1);
+            reference.insert(key, key + 1);
+        }
+    }
+    for (int key = 0; key < 5000; key++) {
+        ASSERT_EQ(tree.find(key), reference.find(key));
+    }
+    EXPECT_EQ(tree.range_find(100, 4000), reference.range_find(100, 4000));
+
+    BPlusTree<std::string, 16> string_tree;
+    string_tree.insert("apple", 1);
+    string_tree.insert("banana", 2);
+    EXPECT_EQ(string_tree.find("banana"), 2);
+
+    EXPECT_THROW((BPlusTree<int, 16>(8)), std::runtime_error);
+    BPlusTree<int> other_order(8);
+    other_order.insert(1, 1);
+    other_order.serialize("order_test");
+    EXPECT_THROW(tree.deserialize("order_test"), std::runtime_error);
+    // 阶数不匹配时树的当前内容保持不变
+    EXPECT_EQ(tree.find(1000), reference.find(1000));
+    EXPECT_EQ(tree.range_find(100, 4000), reference.range_find(100, 4000));
+}
+
+// 测试字符串键的公共前缀与键头查找，覆盖前缀相同、长度不同及含\0的键
+TEST(BPlusTreeTest, PrefixCompressedStringKeys) {
+    LeafNode<std::string>* leaf = LeafNode<std::string>::create(8);
+    for (std::string key : {"tenant/eu/b", "tenant/eu/a", "tenant/eu/ab"}) {
+        leaf->insert_in_node(key, 1, nullptr, 8);
+    }
+    EXPECT_EQ(leaf->keys.prefix_length(), 10);
+    EXPECT_EQ(leaf->find_index("tenant/eu/aa"), 1);
+    EXPECT_EQ(leaf->find_index("tenant/a"), 0);
+    EXPECT_EQ(leaf->find_index("tenant/us"), 3);
+    leaf->insert_in_node("tenant/asia", 1, nullptr, 8);
+    EXPECT_EQ(leaf->keys.prefix_length(), 7);
+    EXPECT_EQ(leaf->find_index("tenant/eu/b"), 3);
+    // 前缀只存一份，后缀区为"asia" "eu/a" "eu/ab" "eu/b"
+    EXPECT_EQ(leaf->keys.suffix_bytes(), 17u);
+    EXPECT_EQ(leaf->keys[2], "tenant/eu/ab");
+    EXPECT_TRUE(leaf->keys.equals(3, "tenant/eu/b"));
+    EXPECT_FALSE(leaf->keys.equals(3, "tenant/eu/ba"));
+    delete leaf;
+
+    BPlusTree<std::string> tree(8);
+    std::map<std::string, uint64_t> reference;
+    std::mt19937 rng(11);
+    for (int i = 0; i < 20000; i++) {
+        std::string key = "tenant/region-" + std::to_string(rng() % 3) + "/";
+        key += std::string(rng() % 3, 'x');
+        key += std::to_string(rng() % 500);
+        if (rng() % 4 == 0) key.push_back('\0');
+        if (rng() % 3 == 0) {
+            tree.remove(key);
+            reference.erase(key);
+        } else {
+            tree.insert(key, i + 1);
+            reference[key] = i + 1;
+        }
+    }
+    for (auto& kv : reference) {
+        ASSERT_EQ(tree.find(kv.first), kv.second);
+    }
+    auto results = tree.range_find("tenant/region-0/", "tenant/region-2/");
+    auto begin = reference.lower_bound("tenant/region-0/");
+    auto end = reference.upper_bound("tenant/region-2/");
+    ASSERT_EQ(results.size(), std::distance(begin, end));
+    for (auto& kv : results) {
+        ASSERT_EQ(kv.first, begin->first);
+        ++begin;
+    }
+}
+
+// 测试批量构建：并行构建叶子层后查找、范围查询和后续增删均正常
+TEST(BPlusTreeTest, BulkLoad) {
+    std::vector<std::pair<int, uint64_t>> items;
+    for (int i = 0; i < 100000; i++) items.emplace_back(i * 2, i);
+
+    BPlusTree<int> tree(16);
+    tree.insert(-5, 1);
+    tree.bulk_load(items.begin(), items.end(), 0.7, 4);
+    EXPECT_EQ(tree.find(-5), 0);
+    for (int i = 0; i < 100000; i++) {
+        ASSERT_EQ(tree.find(i * 2), i);
+    }
+    auto results = tree.range_find(1000, 1998);
+    ASSERT_EQ(results.size(), 500);
+    EXPECT_EQ(results.front().second, 500);
+
+    for (int i = 0; i < 100000; i += 2) tree.remove(i * 2);
+    for (int i = 0; i < 1000; i++) tree.insert(i * 2 + 1, i);
+    EXPECT_EQ(tree.find(4), 0);
+    EXPECT_EQ(tree.find(6), 3);
+    EXPECT_EQ(tree.find(7), 3);
+
+    std::vector<std::pair<std::string, uint64_t>> words = {{"apple", 1}, {"banana", 2}, {"cherry", 3}};
+    BPlusTree<std::string> string_tree(3);
+    string_tree.bulk_load(words.begin(), words.end());
+    EXPECT_EQ(string_tree.find("banana"), 2);
+
+    std::swap(items[10], items[11]);
+    EXPECT_THROW(tree.bulk_load(items.begin(), items.end()), std::runtime_error);
+    // 输入无序时当前内容保持不变
+    EXPECT_EQ(tree.find(6), 3);
+    EXPECT_EQ(tree.find(7), 3);
+    tree.insert(100001, 5);
+    EXPECT_EQ(tree.find(100001), 5);
+}
+
+// 测试批量加载的节点填充：填充率为0.5时除根外的节点仍不低于半满，也不超过阶数
+TEST(BPlusTreeTest, BulkLoadNodeFill) {
+    const int order = 64;
+    for (int count : {33, 64, 65, 97, 2080, 2081, 4200, 100000}) {
+        std::vector<std::pair<int, uint64_t>> items;
+        for (int i = 0; i < count; i++) items.emplace_back(i, i + 1);
+
+        BPlusTree<int> tree(order);
+        tree.bulk_load(items.begin(), items.end(), 0.5);
+        tree.serialize("fill_tree");
+
+        // 按索引逐条读取记录的类型与大小，第一条记录为根
+        std::ifstream index_file("fill_tree.index", std::ios::binary);
+        std::ifstream data_file("fill_tree.data", std::ios::binary);
+        uint64_t data_size;
+        int32_t records;
+        index_file.read(reinterpret_cast<char*>(&data_size), sizeof(data_size));
+        index_file.read(reinterpret_cast<char*>(&records), sizeof(records));
+        std::vector<uint64_t> offsets(records);
+        index_file.read(reinterpret_cast<char*>(offsets.data()), sizeof(uint64_t) * records);
+        ASSERT_TRUE(index_file);
+
+        long long leaf_entries = 0;
+        for (int r = 0; r < records; r++) {
+            int32_t id, size;
+            char type;
+            data_file.seekg(offsets[r]);
+            data_file.read(reinterpret_cast<char*>(&id), sizeof(id));
+            data_file.read(&type, sizeof(type));
+            data_file.read(reinterpret_cast<char*>(&size), sizeof(size));
+            ASSERT_TRUE(data_file);
+            // 内部节点的大小为分隔键数，子节点数为size + 1
+            int entries = type == 1 ? size : size + 1;
+            int min_entries = type == 1 ? (order + 1) / 2 : (order + 1) / 2 + 1;
+            int max_entries = type == 1 ? order : order + 1;
+            if (type == 1) leaf_entries += size;
+            EXPECT_LE(entries, max_entries) << "count " << count << ", record " << r;
+            if (r > 0) EXPECT_GE(entries, min_entries) << "count " << count << ", record " << r;
+        }
+        EXPECT_EQ(leaf_entries, count);
+        EXPECT_EQ(tree.find(count - 1), static_cast<uint64_t>(count));
+    }
+    for (const char* file : {"fill_tree.header", "fill_tree.data", "fill_tree.index"}) std::remove(file);
+}
+
+// 持久化模式下的文件：检查点与各日志段
+static std::vector<std::string> wal_files(const std::string& base) {
+    std::vector<std::string> files;
+    for (const auto& entry : std::filesystem::directory_iterator(".")) {
+        std::string name = entry.path().filename().string();
+        if (name.rfind(base + ".ckpt", 0) == 0 || name.rfind(base + ".wal.", 0) == 0) files.push_back(name);
+    }
+    return files;
+}
+
+// 复制已提交的文件，模拟不经过析构的崩溃
+static void copy_wal_files(const std::string& from, const std::string& to) {
+    for (const auto& file : wal_files(to)) std::remove(file.c_str());
+    for (const auto& file : wal_files(from)) {
+        std::ifstream in(file, std::ios::binary);
+        std::ofstream(to + file.substr(from.size()), std::ios::binary) << in.rdbuf();
+    }
+}
+
+// 预写日志：崩溃后从检查点和日志恢复，被截断的日志尾部被忽略
+TEST(BPlusTreeTest, WalRecovery) {
+    for (const auto& file : wal_files("wal_tree")) std::remove(file.c_str());
+    {
+        BPlusTree<int> tree(8);
+        WalOptions options;
+        options.group_commit_delay = std::chrono::microseconds(50);
+        tree.open("wal_tree", options);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; t++) {
+            threads.emplace_back([&tree, t] {
+                for (int i = t * 1000; i < (t + 1) * 1000; i++) tree.insert(i, i + 1);
+            });
+        }
+        for (auto& thread : threads) thread.join();
+        tree.checkpoint();
+        for (int i = 0; i < 4000; i += 2) tree.remove(i);
+        tree.insert(100000, 7);
+        copy_wal_files("wal_tree", "crash_tree");
+    }
+    {
+        BPlusTree<int> tree(8);
+        tree.open("crash_tree");
+        for (int i = 0; i < 4000; i++) {
+            ASSERT_EQ(tree.find(i), i % 2 ? i + 1 : 0);
+        }
+        EXPECT_EQ(tree.find(100000), 7);
+    }
+
+    std::ofstream("crash_tree.wal.1", std::ios::binary | std::ios::app) << "\x09\x00\x00";
+    {
+        BPlusTree<int> tree(8);
+        tree.open("crash_tree");
+        EXPECT_EQ(tree.find(3), 4);
+        tree.insert(2, 55);
+    }
+    BPlusTree<int> tree(8);
+    tree.open("crash_tree");
+    EXPECT_EQ(tree.find(2), 55);
+    EXPECT_EQ(tree.find(100000), 7);
+
+    // 写出失败后错误一直保留，失败批次中的记录不会被当作已落盘
+    if (std::ifstream("/dev/full")) {
+        WriteAheadLog log("/dev/full", WalOptions());
+        uint64_t lsn = log.append("abc", 3);
+        EXPECT_THROW(log.wait_durable(lsn), std::runtime_error);
+        EXPECT_THROW(log.wait_durable(lsn), std::runtime_error);
+        EXPECT_THROW(log.append("d", 1), std::runtime_error);
+    }
+}
+
+// 日志写出失败后写操作抛出异常并释放节点锁，追加失败的修改不会生效
+TEST(BPlusTreeTest, WalFailureReleasesLocks) {
+    if (!std::ifstream("/dev/full")) return;
+    for (const auto& file : wal_files("failing_tree")) std::remove(file.c_str());
+    {
+        BPlusTree<int> tree(4);
+        tree.open("failing_tree");
+        for (int i = 0; i < 20; i++) tree.insert(i, i);
+
+        // 检查点切换到的新段指向/dev/full，之后每次写出都失败
+        std::filesystem::create_symlink("/dev/full", "failing_tree.wal.1");
+        tree.checkpoint();
+        EXPECT_THROW(tree.insert(100, 1), std::runtime_error);  // 追加成功，提交时写出失败
+        EXPECT_THROW(tree.insert(101, 1), std::runtime_error);  // 追加即失败
+        EXPECT_THROW(tree.insert_batch({{102, 1}, {103, 1}}), std::runtime_error);
+        EXPECT_THROW(tree.remove(5), std::runtime_error);
+        EXPECT_THROW(tree.remove(100), std::runtime_error);
+
+        // 同一叶子及其祖先上的锁都已释放
+        EXPECT_EQ(tree.find(101), 0);
+        EXPECT_EQ(tree.find(102), 0);
+        EXPECT_EQ(tree.find(5), 5);
+        EXPECT_EQ(tree.find(100), 1);
+        EXPECT_EQ(tree.range_count(0, 200), 21);
+    }
+    for (const auto& file : wal_files("failing_tree")) std::remove(file.c_str());
+}
+
+// 增量检查点只写出被修改的叶子，累计到上限后改写全量检查点
+TEST(BPlusTreeTest, IncrementalCheckpoint) {
+    for (const auto& file : wal_files("delta_tree")) std::remove(file.c_str());
+    BPlusTree<int> tree(32);
+    WalOptions options;
+    options.max_checkpoint_deltas = 2;
+    tree.open("delta_tree", options);
+    std::vector<std::pair<int, uint64_t>> items;
+    for (int i = 0; i < 20000; i++) items.emplace_back(i, i);
+    tree.insert_batch(items);
+    tree.checkpoint();
+    auto full_size = std::filesystem::file_size("delta_tree.ckpt");
+
+    for (int i = 0; i < 10; i++) tree.insert(i * 1000, 7);
+    tree.checkpoint();
+    for (int i = 5000; i < 5200; i++) tree.remove(i);
+    tree.checkpoint();
+    auto deltas = wal_files("delta_tree");
+    auto delta_count = std::count_if(deltas.begin(), deltas.end(),
+                                     [](const std::string& name) { return name.rfind("delta_tree.ckpt.", 0) == 0; });
+    EXPECT_EQ(delta_count, 2);
+    for (const auto& name : deltas) {
+        if (name.rfind("delta_tree.ckpt.", 0) == 0) {
+            EXPECT_LT(std::filesystem::file_size(name) * 20, full_size);
+        }
+    }
+
+    copy_wal_files("delta_tree", "delta_crash");
+    {
+        BPlusTree<int> recovered(32);
+        recovered.open("delta_crash");
+        EXPECT_EQ(recovered.range_find(0, 20000), tree.range_find(0, 20000));
+    }
+
+    // 第三次增量达到上限，改写全量并删除增量
+    tree.insert(-1, 1);
+    tree.checkpoint();
+    deltas = wal_files("delta_tree");
+    EXPECT_EQ(std::count_if(deltas.begin(), deltas.end(),
+                            [](const std::string& name) { return name.rfind("delta_tree.ckpt.", 0) == 0; }),
+              0);
+    copy_wal_files("delta_tree", "delta_crash");
+    BPlusTree<int> recovered(32);
+    recovered.open("delta_crash");
+    EXPECT_EQ(recovered.range_find(-1, 20000), tree.range_find(-1, 20000));
+}
+
+// 可映射快照：打开后直接查询，第一次写入时才物化为内存中的树
+TEST(BPlusTreeTest, MappedSnapshot) {
+    BPlusTree<int> tree(16);
+    for (int i = 0; i < 30000; i++) tree.insert(i * 2, i);
+    tree.serialize_mapped("mapped_tree.snap");
+
+    MappedSnapshot<int> snapshot("mapped_tree.snap");
+    EXPECT_EQ(snapshot.size(), 30000);
+    for (int i = 0; i < 30000; i++) {
+        ASSERT_EQ(snapshot.find(i * 2), i);
+        ASSERT_EQ(snapshot.find(i * 2 + 1), 0);
+    }
+    EXPECT_EQ(snapshot.range_find(101, 2000), tree.range_find(101, 2000));
+    EXPECT_FALSE(snapshot.materialized());
+
+    snapshot.insert(1, 42);
+    snapshot.remove(0);
+    EXPECT_TRUE(snapshot.materialized());
+    EXPECT_EQ(snapshot.find(1), 42);
+    EXPECT_EQ(snapshot.find(0), 0);
+    EXPECT_EQ(snapshot.find(59998), 29999);
+    EXPECT_EQ(snapshot.size(), 30000);
+
+    BPlusTree<std::string> string_tree(8);
+    for (int i = 0; i < 2000; i++) string_tree.insert("user_" + std::to_string(i), i);
+    string_tree.serialize_mapped("mapped_string_tree.snap");
+    MappedSnapshot<std::string> string_snapshot("mapped_string_tree.snap");
+    EXPECT_EQ(string_snapshot.find("user_1234"), 1234);
+    EXPECT_EQ(string_snapshot.find("user_"), 0);
+    EXPECT_EQ(string_snapshot.range_find("user_10", "user_11"), string_tree.range_find("user_10", "user_11"));
+    EXPECT_THROW(MappedSnapshot<int>("mapped_string_tree.snap"), std::runtime_error);
+}
+
+// 带节点偏移索引的快照并行反序列化，删除索引后退回逐条读取，结果一致
+TEST(BPlusTreeTest, ParallelDeserialize) {
+    BPlusTree<int> tree(32);
+    std::mt19937 rng(11);
+    for (int i = 0; i < 100000; i++) tree.insert(rng() % 1000000, i);
+    tree.serialize("parallel_tree");
+
+    BPlusTree<int> parallel(32, true);
+    parallel.deserialize("parallel_tree", 4);
+    auto expected = tree.range_find(0, 1000000);
+    EXPECT_EQ(parallel.range_find(0, 1000000), expected);
+    EXPECT_EQ(parallel.size(), expected.size());
+    EXPECT_EQ(parallel.range_find_reverse(0, 1000000).front(), expected.back());
+    parallel.insert(-1, 1);
+    EXPECT_EQ(parallel.rank(0), 1);
+
+    std::remove("parallel_tree.index");
+    BPlusTree<int> sequential(32);
+    sequential.deserialize("parallel_tree", 4);
+    EXPECT_EQ(sequential.range_find(0, 1000000), expected);
+
+    BPlusTree<std::string> string_tree(4);
+    for (int i = 0; i < 3000; i++) string_tree.insert("k" + std::to_string(i), i);
+    string_tree.serialize("parallel_string_tree");
+    BPlusTree<std::string> string_parallel(4);
+    string_parallel.deserialize("parallel_string_tree", 3);
+    EXPECT_EQ(string_parallel.range_find("k", "l"), string_tree.range_find("k", "l"));
+}
+
+// 压缩快照：编码后比普通快照小，多线程解压后内容一致
+TEST(BPlusTreeTest, CompressedSnapshot) {
+    BPlusTree<int> tree(32);
+    std::mt19937 rng(13);
+    for (int i = 0; i < 50000; i++) tree.insert(static_cast<int>(rng() % 2000000) - 1000000, i);
+    tree.insert(std::numeric_limits<int>::min(), 1);
+    tree.insert(std::numeric_limits<int>::max(), 2);
+    tree.serialize("compressed_tree");
+    tree.serialize_compressed("compressed_tree.bptc");
+    EXPECT_LT(std::filesystem::file_size("compressed_tree.bptc"), std::filesystem::file_size("compressed_tree.data") / 2);
+
+    auto expected = tree.range_find(std::numeric_limits<int>::min(), std::numeric_limits<int>::max());
+    BPlusTree<int> restored(16, true);
+    restored.deserialize_compressed("compressed_tree.bptc", 4);
+    EXPECT_EQ(restored.range_find(std::numeric_limits<int>::min(), std::numeric_limits<int>::max()), expected);
+    EXPECT_EQ(restored.size(), expected.size());
+
+    BPlusTree<std::string> string_tree(8);
+    for (int i = 0; i < 10000; i++) string_tree.insert("user:" + std::to_string(i * 7), i);
+    string_tree.insert("", 3);
+    SnapshotCodec codec = codec_available(SnapshotCodec::zlib) ? SnapshotCodec::zlib : SnapshotCodec::none;
+    string_tree.serialize_compressed("compressed_string_tree.bptc", codec);
+    BPlusTree<std::string> string_restored(8);
+    string_restored.deserialize_compressed("compressed_string_tree.bptc", 3);
+    EXPECT_EQ(string_restored.range_find("", "v"), string_tree.range_find("", "v"));
+    EXPECT_THROW(restored.deserialize_compressed("compressed_string_tree.bptc"), std::runtime_error);
+
+    for (const char* file : {"compressed_tree.header", "compressed_tree.data", "compressed_tree.index",
+                             "compressed_tree.bptc", "compressed_string_tree.bptc"}) {
+        std::remove(file);
+    }
+}
+
+// 缓冲写入：回填可跨越已写出与仍在缓冲中的部分
+TEST(BPlusTreeTest, BufferedWriterPatch) {
+    {
+        BufferedFileWriter writer("buffered_writer.bin", 16);
+        for (int32_t i = 0; i < 10; i++) writer.put(i);
+        std::string block(40, 'x');
+        writer.write(block.data(), block.size());
+        writer.put(int32_t(7));
+        int64_t value = -1;
+        writer.patch(12, &value, sizeof(value));
+        writer.patch(76, &value, sizeof(value));
+        EXPECT_EQ(writer.position(), 84u);
+    }
+    std::ifstream file("buffered_writer.bin", std::ios::binary);
+    std::vector<int32_t> ints(10);
+    file.read(reinterpret_cast<char*>(ints.data()), 40);
+    EXPECT_EQ(ints[2], 2);
+    EXPECT_EQ(ints[3], -1);
+    EXPECT_EQ(ints[4], -1);
+    EXPECT_EQ(ints[5], 5);
+    std::string block(40, '\0');
+    file.read(&block[0], 40);
+    EXPECT_EQ(block, std::string(36, 'x') + std::string(4, '\xff'));
+    int32_t last = 0;
+    file.read(reinterpret_cast<char*>(&last), sizeof(last));
+    EXPECT_EQ(last, -1);
+    std::remove("buffered_writer.bin");
+}
+
+// 磁盘模式：关闭后重新打开，数据仍在
+TEST(BPlusTreeTest, DiskTreeReopen) {
+    std::remove("disk_tree.db");
+    std::remove("disk_string_tree.db");
+    {
+        DiskBPlusTree<int> tree("disk_tree.db");
+        std::mt19937 rng(5);
+        std::vector<int> keys(100000);
+        for (int i = 0; i < 100000; i++) keys[i] = i;
+        std::shuffle(keys.begin(), keys.end(), rng);
+        for (int key : keys) tree.insert(key, key + 1);
+        for (int i = 0; i < 100000; i += 3) tree.remove(i);
+        tree.sync();
+    }
+    DiskBPlusTree<int> tree("disk_tree.db");
+    for (int i = 0; i < 100000; i++) {
+        ASSERT_EQ(tree.find(i), i % 3 == 0 ? 0 : i + 1);
+    }
+    auto results = tree.range_find(1000, 1999);
+    ASSERT_EQ(results.size(), 667);
+    EXPECT_EQ(results[2].first, 1003);
+    EXPECT_THROW(DiskBPlusTree<std::string>("disk_tree.db"), std::runtime_error);
+
+    DiskBPlusTree<std::string> string_tree("disk_string_tree.db");
+    for (int i = 0; i < 5000; i++) string_tree.insert("key_" + std::to_string(i), i);
+    EXPECT_EQ(string_tree.find("key_4321"), 4321);
+    EXPECT_EQ(string_tree.find("missing"), 0);
+    EXPECT_THROW(string_tree.insert(std::string(40, 'x'), 1), std::runtime_error);
+    EXPECT_EQ(string_tree.range_find("key_10", "key_11").size(), 112);
+}
+
+// 缓冲池远小于树时仍能正确读写，页帧全部被固定时抛出异常
+TEST(BPlusTreeTest, DiskTreeBufferPool) {
+    std::remove("pool_tree.db");
+    std::vector<int> keys(50000);
+    for (int i = 0; i < 50000; i++) keys[i] = i;
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(7));
+    {
+        DiskBPlusTree<int> tree("pool_tree.db", 16);
+        for (int key : keys) tree.insert(key, key * 2);
+        for (int i = 0; i < 50000; i += 2) tree.remove(i);
+    }
+    DiskBPlusTree<int> tree("pool_tree.db", 8);
+    for (int key : keys) {
+        ASSERT_EQ(tree.find(key), key % 2 ? key * 2 : 0);
+    }
+    EXPECT_GT(tree.page_misses(), 1000);
+    EXPECT_EQ(tree.range_find(0, 49999).size(), 25000);
+    EXPECT_THROW(DiskBPlusTree<int>("pool_tree.db", 2), std::runtime_error);
+
+    PageFile file("pool_tree.db");
+    BufferPool pool(file, 4);
+    std::vector<PageHandle> pinned;
+    for (uint64_t id = 1; id <= 4; id++) pinned.push_back(pool.fetch(id));
+    EXPECT_THROW(pool.fetch(5), std::runtime_error);
+    pinned.pop_back();
+    EXPECT_EQ(pool.fetch(5).id(), 5);
+}
+
 // 插入查找性能测试
 TEST(BPlusTreePerf, BulkInsert) {
     const int N = 100000;
@@ -277,6 +908,439 @@ TEST(BPlusTreeConcurrencyTest, ConcurrentRangeQuery) {
     ASSERT_GT(total_results, 0);
 }
 
+// 测试序列化与并发写入互斥：序列化得到的快照必须是完整的树
+TEST(BPlusTreeConcurrencyTest, SerializeDuringWrites) {
+    BPlusTree<int> tree(4);
+    std::atomic<bool> stop(false);
+    std::vector<std::thread> writers;
+    for (int i = 0; i < 4; i++) {
+        writers.emplace_back([&, i] {
+            for (int j = i; !stop; j += 4) {
+                tree.insert(j % 5000, (j % 5000) * 10);
+                if (j % 3 == 0) tree.remove((j / 3) % 5000);
+            }
+        });
+    }
+
+    for (int round = 0; round < 5; round++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        tree.serialize("gate_tree");
+
+        BPlusTree<int> restored(4);
+        restored.deserialize("gate_tree");
+        auto results = restored.range_find(0, 5000);
+        for (size_t k = 0; k < results.size(); k++) {
+            ASSERT_EQ(results[k].second, results[k].first * 10);
+            if (k > 0) {
+                ASSERT_LT(results[k - 1].first, results[k].first);
+            }
+        }
+    }
+    stop = true;
+    for (auto& t : writers) t.join();
+}
+
+// 测试B-link分裂：并发插入频繁分裂后，叶子链表仍完整有序
+TEST(BPlusTreeConcurrencyTest, ConcurrentInsertWithSplits) {
+    BPlusTree<int> tree(3);
+    BPlusTree<std::string> string_tree(3);
+    const int num_threads = 8;
+    const int num_per_thread = 500;
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < num_threads; i++) {
+        threads.emplace_back([&, i] {
+            for (int j = 0; j < num_per_thread; j++) {
+                int key = j * num_threads + i;
+                tree.insert(key, key * 10);
+                string_tree.insert(std::to_string(100000 + key), key);
+            }
+        });
+    }
+
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    const int total = num_threads * num_per_thread;
+    auto results = tree.range_find(0, total);
+    ASSERT_EQ(results.size(), total);
+    for (int i = 0; i < total; i++) {
+        ASSERT_EQ(results[i].first, i);
+        ASSERT_EQ(results[i].second, i * 10);
+    }
+
+    auto string_results = string_tree.range_find("100000", "199999");
+    ASSERT_EQ(string_results.size(), total);
+    for (int i = 0; i < total; i++) {
+        ASSERT_EQ(string_results[i].second, i);
+    }
+}
+
+// 测试批量插入：多个线程并发写入乱序批次，批内重复键以最后一个值为准
+TEST(BPlusTreeConcurrencyTest, ConcurrentInsertBatch) {
+    BPlusTree<int> tree(8);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&, t] {
+            std::mt19937 rng(t);
+            for (int round = 0; round < 10; round++) {
+                std::vector<std::pair<int, uint64_t>> batch;
+                for (int i = 0; i < 500; i++) {
+                    int key = (round * 500 + i) * 4 + t;
+                    batch.emplace_back(key, 0);
+                    batch.emplace_back(key, key);
+                }
+                std::shuffle(batch.begin(), batch.end(), rng);
+                std::stable_sort(batch.begin(), batch.end(),
+                                 [](const std::pair<int, uint64_t>& a, const std::pair<int, uint64_t>& b) {
+                                     return a.second < b.second;
+                                 });
+                tree.insert_batch(batch);
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    for (int key = 0; key < 20000; key++) {
+        ASSERT_EQ(tree.find(key), key);
+    }
+    EXPECT_EQ(tree.range_find(0, 19999).size(), 20000);
+}
+
+// 同时存活的线程多于线程槽位：多出的线程共用溢出槽位，操作仍然正确，独占操作也能完成
+TEST(BPlusTreeConcurrencyTest, MoreThreadsThanSlots) {
+    const int thread_count = MAX_THREAD_SLOTS + 44;
+    const int per_thread = 40;
+    BPlusTree<int> tree(4);
+    std::atomic<int> arrived(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_count; t++) {
+        threads.emplace_back([&, t] {
+            // 先各自领取槽位，全部线程到齐后再并发写入，保证槽位已用尽
+            tree.insert(t * per_thread, t);
+            arrived++;
+            while (arrived < thread_count) std::this_thread::yield();
+
+            for (int i = 1; i < per_thread; i++) tree.insert(t * per_thread + i, t);
+            for (int i = 0; i < per_thread; i += 2) tree.remove(t * per_thread + i);
+            if (t % 50 == 0) tree.serialize("slot_tree");
+            for (int i = 1; i < per_thread; i += 2) ASSERT_EQ(tree.find(t * per_thread + i), t);
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    for (int t = 0; t < thread_count; t++) {
+        for (int i = 0; i < per_thread; i++) {
+            ASSERT_EQ(tree.find(t * per_thread + i), i % 2 == 1 ? t : 0);
+        }
+    }
+    EXPECT_EQ(tree.range_find(0, thread_count * per_thread).size(), thread_count * per_thread / 2);
+    for (const char* file : {"slot_tree.header", "slot_tree.data", "slot_tree.index"}) std::remove(file);
+}
+
+// 计数模式下的并发写入：各线程按叶子并发插入、批量插入和删除，期间并发读取计数；
+// 写入结束后计数精确
+TEST(BPlusTreeConcurrencyTest, CountedConcurrentWrites) {
+    BPlusTree<int> tree(4, true);
+    const int threads_count = 4;
+    const int per_thread = 3000;
+    std::atomic<bool> done{false};
+    std::thread reader([&] {
+        std::mt19937 rng(99);
+        while (!done) {
+            // 进行中的写入可能已计入叶子而尚未计入祖先，结果只在写入结束后精确
+            int start = rng() % (threads_count * per_thread);
+            ASSERT_LE(tree.range_count(start, start + 500), static_cast<size_t>(threads_count * per_thread));
+            size_t size = tree.size();
+            if (size > 0) {
+                size_t k = rng() % size;
+                try {
+                    tree.select(k);
+                } catch (const std::runtime_error&) {
+                    // 并发删除可能使k越界
+                }
+            }
+            ASSERT_LE(tree.rank(start), static_cast<size_t>(threads_count * per_thread));
+        }
+    });
+
+    std::vector<std::thread> writers;
+    for (int t = 0; t < threads_count; t++) {
+        writers.emplace_back([&tree, t] {
+            std::vector<std::pair<int, uint64_t>> batch;
+            for (int i = 0; i < per_thread; i++) {
+                int key = i * threads_count + t;
+                if (i % 3 == 0) {
+                    batch.emplace_back(key, key);
+                } else {
+                    tree.insert(key, key);
+                }
+                if (batch.size() == 64) {
+                    tree.insert_batch(batch);
+                    batch.clear();
+                }
+            }
+            tree.insert_batch(batch);
+            // 删除一半的键，触发借用与合并
+            for (int i = 0; i < per_thread; i += 2) tree.remove(i * threads_count + t);
+        });
+    }
+    for (auto& t : writers) t.join();
+    done = true;
+    reader.join();
+
+    std::vector<int> expected;
+    for (int key = 0; key < threads_count * per_thread; key++) {
+        if ((key / threads_count) % 2 == 1) expected.push_back(key);
+    }
+    ASSERT_EQ(tree.size(), expected.size());
+    for (size_t k = 0; k < expected.size(); k++) {
+        ASSERT_EQ(tree.select(k).first, expected[k]);
+        ASSERT_EQ(tree.rank(expected[k]), k);
+    }
+    EXPECT_EQ(tree.range_count(0, threads_count * per_thread), expected.size());
+    EXPECT_EQ(tree.range_count(100, 199), tree.range_aggregate(100, 199).count);
+}
+
+// 在线检查点：写操作不停顿，崩溃后由检查点和之后的日志段恢复出全部已提交的写入
+TEST(BPlusTreeConcurrencyTest, CheckpointDuringWrites) {
+    for (const auto& file : wal_files("online_tree")) std::remove(file.c_str());
+    BPlusTree<int> tree(16);
+    tree.open("online_tree");
+    std::atomic<bool> done{false};
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 3; t++) {
+        writers.emplace_back([&tree, t] {
+            for (int i = 0; i < 3000; i++) {
+                int key = i * 3 + t;
+                tree.insert(key, key + 1);
+                if (i % 4 == 0) tree.remove(key - 3 * 100);
+            }
+        });
+    }
+    std::thread checkpointer([&] {
+        while (!done) {
+            tree.checkpoint();
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    });
+    for (auto& writer : writers) writer.join();
+    done = true;
+    checkpointer.join();
+    copy_wal_files("online_tree", "online_crash");
+
+    BPlusTree<int> recovered(16);
+    recovered.open("online_crash");
+    EXPECT_EQ(recovered.range_find(-1000, 10000), tree.range_find(-1000, 10000));
+}
+
+// 测试乐观读：写者持续分裂/合并节点时，读者仍能读到稳定存在的键
+TEST(BPlusTreeConcurrencyTest, OptimisticFindDuringWrites) {
+    BPlusTree<int> tree(4);
+    // 偶数键始终存在，写者只插入删除奇数键
+    for (int i = 0; i < 2000; i += 2) {
+        tree.insert(i, i * 10);
+    }
+
+    std::atomic<bool> stop(false);
+    std::vector<std::thread> writers;
+    for (int i = 0; i < 2; i++) {
+        writers.emplace_back([&, i] {
+            for (int round = 0; round < 5; round++) {
+                for (int j = 1 + i * 2; j < 2000; j += 4) tree.insert(j, j * 10);
+                for (int j = 1 + i * 2; j < 2000; j += 4) tree.remove(j);
+            }
+        });
+    }
+
+    std::vector<std::thread> readers;
+    std::atomic<int> missing(0);
+    for (int i = 0; i < 4; i++) {
+        readers.emplace_back([&] {
+            while (!stop) {
+                for (int j = 0; j < 2000; j += 2) {
+                    if (tree.find(j) != static_cast<uint64_t>(j * 10)) missing++;
+                }
+            }
+        });
+    }
+
+    for (auto& t : writers) t.join();
+    stop = true;
+    for (auto& t : readers) t.join();
+
+    EXPECT_EQ(missing, 0);
+}
+
+// 测试epoch回收：其他线程仍在临界区时被摘除的对象不会被释放
+static std::atomic<int> epoch_freed(0);
+
+TEST(BPlusTreeConcurrencyTest, EpochReclaimWaitsForReaders) {
+    epoch_freed = 0;
+    EpochManager manager;
+    auto deleter = [](void* p) {
+        delete static_cast<int*>(p);
+        epoch_freed++;
+    };
+
+    std::atomic<bool> entered(false), leave(false);
+    std::thread reader([&] {
+        EpochGuard guard(manager);
+        entered = true;
+        while (!leave) std::this_thread::yield();
+    });
+    while (!entered) std::this_thread::yield();
+
+    {
+        EpochGuard guard(manager);
+        for (int i = 0; i < 500; i++) manager.retire(new int(i), deleter);
+    }
+    EXPECT_EQ(epoch_freed, 0);
+
+    leave = true;
+    reader.join();
+    // 摘除很少时，之后的操作离开临界区也会推进epoch并回收
+    {
+        EpochGuard guard(manager);
+        manager.retire(new int(0), deleter);
+    }
+    for (int i = 0; i < 2; i++) {
+        EpochGuard guard(manager);
+    }
+    EXPECT_EQ(epoch_freed, 501);
+
+    for (int i = 0; i < 500; i++) {
+        EpochGuard guard(manager);
+        manager.retire(new int(i), deleter);
+    }
+    EXPECT_GT(epoch_freed, 501);
+
+    manager.reclaim_all();
+    EXPECT_EQ(epoch_freed, 1001);
+}
+
+// 测试批量查找：写者持续分裂/合并节点时，批量查找结果与单键查找一致
+TEST(BPlusTreeConcurrencyTest, FindBatchDuringWrites) {
+    BPlusTree<int> tree(4);
+    std::vector<int> keys;
+    for (int i = 0; i < 2000; i += 2) {
+        tree.insert(i, i * 10);
+        keys.push_back(i);
+        keys.push_back(i + 1);  // 奇数键可能存在也可能不存在
+    }
+
+    std::atomic<bool> stop(false);
+    std::thread writer([&] {
+        while (!stop) {
+            for (int j = 1; j < 2000; j += 2) tree.insert(j, j * 10);
+            for (int j = 1; j < 2000; j += 2) tree.remove(j);
+        }
+    });
+
+    for (int round = 0; round < 50; round++) {
+        std::vector<uint64_t> results = tree.find_batch(keys);
+        ASSERT_EQ(results.size(), keys.size());
+        for (size_t i = 0; i < keys.size(); i++) {
+            uint64_t expected = keys[i] * 10;
+            ASSERT_TRUE(results[i] == expected || (keys[i] % 2 == 1 && results[i] == 0));
+        }
+    }
+    stop = true;
+    writer.join();
+
+    BPlusTree<std::string> string_tree(3);
+    string_tree.insert("a", 1);
+    string_tree.insert("c", 3);
+    EXPECT_EQ(string_tree.find_batch({"c", "b", "a"}), (std::vector<uint64_t>{3, 0, 1}));
+}
+
+// 测试范围游标：并发插入删除时游标按键递增返回，稳定存在的键不会遗漏
+TEST(BPlusTreeConcurrencyTest, CursorScanDuringWrites) {
+    BPlusTree<int> tree(4);
+    for (int i = 0; i < 4000; i += 2) tree.insert(i, i);
+
+    std::atomic<bool> stop(false);
+    std::thread writer([&] {
+        while (!stop) {
+            for (int j = 1; j < 4000; j += 2) tree.insert(j, j);
+            for (int j = 1; j < 4000; j += 2) tree.remove(j);
+        }
+    });
+
+    for (int round = 0; round < 20; round++) {
+        int expected_even = 100;
+        int last = -1;
+        for (auto cursor = tree.scan(100); cursor.valid(); cursor.next()) {
+            ASSERT_GT(cursor.key(), last);
+            ASSERT_EQ(cursor.value(), cursor.key());
+            last = cursor.key();
+            if (last % 2 == 0) {
+                ASSERT_EQ(last, expected_even);
+                expected_even += 2;
+            }
+        }
+        EXPECT_EQ(expected_even, 4000);
+    }
+    stop = true;
+    writer.join();
+
+    // 提前停止
+    BPlusTree<std::string> string_tree(3);
+    for (std::string key : {"a", "b", "c", "d", "e"}) string_tree.insert(key, 1);
+    auto cursor = string_tree.scan("bb");
+    ASSERT_TRUE(cursor.valid());
+    EXPECT_EQ(cursor.key(), "c");
+    cursor.next();
+    EXPECT_EQ(cursor.key(), "d");
+    EXPECT_FALSE(string_tree.scan("f").valid());
+}
+
+// 测试逆序扫描：并发插入删除时按键递减返回，稳定存在的键不会遗漏，limit生效
+TEST(BPlusTreeConcurrencyTest, ReverseScanDuringWrites) {
+    BPlusTree<int> tree(4);
+    for (int i = 0; i < 4000; i += 2) tree.insert(i, i);
+
+    std::atomic<bool> stop(false);
+    std::thread writer([&] {
+        while (!stop) {
+            for (int j = 1; j < 4000; j += 2) tree.insert(j, j);
+            for (int j = 1; j < 4000; j += 2) tree.remove(j);
+        }
+    });
+
+    for (int round = 0; round < 20; round++) {
+        int expected_even = 3000;
+        int last = 4000;
+        for (auto cursor = tree.scan_reverse(3000); cursor.valid(); cursor.next()) {
+            ASSERT_LT(cursor.key(), last);
+            last = cursor.key();
+            if (last % 2 == 0) {
+                ASSERT_EQ(last, expected_even);
+                expected_even -= 2;
+            }
+        }
+        EXPECT_EQ(expected_even, -2);
+    }
+    stop = true;
+    writer.join();
+
+    auto latest = tree.range_find_reverse(100, 2000, 5);
+    ASSERT_EQ(latest.size(), 5);
+    EXPECT_EQ(latest.front().first, 2000);
+    EXPECT_EQ(latest.back().first, 1992);
+    EXPECT_EQ(tree.range_find_reverse(100, 2000).size(), 951);
+
+    BPlusTree<std::string> string_tree(3);
+    for (std::string key : {"a", "b", "c", "d", "e"}) string_tree.insert(key, 1);
+    auto cursor = string_tree.scan_reverse("cc");
+    ASSERT_TRUE(cursor.valid());
+    EXPECT_EQ(cursor.key(), "c");
+    cursor.next();
+    EXPECT_EQ(cursor.key(), "b");
+    EXPECT_FALSE(string_tree.scan_reverse("0").valid());
+}
+
 const int data_size = 1000000;
 
 // 测试插入操作的吞吐量
@@ -422,4 +1486,73 @@ TEST(BPlusTreePerformanceTest, MixedOperations) {
     test_with_threads(2, 0.4, 0.1);
     test_with_threads(4, 0.4, 0.1);
     test_with_threads(8, 0.4, 0.1);
-}
\ No newline at end of file
+}
+// 节点内查找微基准：SIMD下界查找与std::lower_bound对比
+TEST(BPlusTreePerformanceTest, NodeSearchMicrobenchmark) {
+    std::cout << "SIMD variant: " << simd_search_variant() << "\n";
+    std::mt19937 rng(42);
+    const int queries = 2000000;
+
+    for (int order : {16, 64, 100, 128, 256}) {
+        std::vector<int32_t> keys(order);
+        std::vector<int64_t> wide_keys(order);
+        int32_t next = 0;
+        for (int i = 0; i < order; i++) {
+            next += 1 + rng() % 8;
+            keys[i] = next;
+            wide_keys[i] = static_cast<int64_t>(next) << 32;
+        }
+        std::vector<int32_t> probes(queries);
+        for (auto& p : probes) p = rng() % (next + 2) - 1;
+
+        for (int i = 0; i < 1000; i++) {
+            int32_t p = probes[i];
+            int expected = std::lower_bound(keys.begin(), keys.end(), p) - keys.begin();
+            ASSERT_EQ(simd_lower_bound(keys.data(), order, p), expected);
+            ASSERT_EQ(simd_lower_bound(wide_keys.data(), order, static_cast<int64_t>(p) << 32), expected);
+        }
+
+        auto time_search = [&](auto search) {
+            long long checksum = 0;
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int32_t p : probes) checksum += search(p);
+            auto end = std::chrono::high_resolution_clock::now();
+            std::chrono::duration<double> duration = end - start;
+            return std::make_pair(duration.count(), checksum);
+        };
+        auto baseline = time_search([&](int32_t p) { return std::lower_bound(keys.begin(), keys.end(), p) - keys.begin(); });
+        auto simd = time_search([&](int32_t p) { return simd_lower_bound(keys.data(), order, p); });
+        EXPECT_EQ(baseline.second, simd.second);
+
+        std::cout << "Order: " << order << " | lower_bound: " << baseline.first * 1e9 / queries << "ns"
+                  << " | simd: " << simd.first * 1e9 / queries << "ns\n";
+    }
+}
+
+// 批量查找与逐个查找的吞吐量对比
+TEST(BPlusTreePerformanceTest, FindBatchThroughput) {
+    std::vector<std::pair<int, uint64_t>> items;
+    for (int i = 0; i < data_size * 4; i++) items.emplace_back(i, i + 1);
+    BPlusTree<int> tree(100);
+    tree.bulk_load(items.begin(), items.end());
+
+    std::mt19937 rng(3);
+    std::vector<int> keys(data_size);
+    for (auto& key : keys) key = rng() % (data_size * 4);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    uint64_t checksum = 0;
+    for (int key : keys) checksum += tree.find(key);
+    auto mid = std::chrono::high_resolution_clock::now();
+    uint64_t batch_checksum = 0;
+    for (size_t i = 0; i < keys.size(); i += 1024) {
+        std::vector<int> batch(keys.begin() + i, keys.begin() + std::min(keys.size(), i + 1024));
+        for (uint64_t value : tree.find_batch(batch)) batch_checksum += value;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    EXPECT_EQ(checksum, batch_checksum);
+
+    std::chrono::duration<double> single = mid - start, batched = end - mid;
+    std::cout << "find: " << data_size / single.count() << " ops/s | find_batch: " << data_size / batched.count()
+              << " ops/s\n";
+}